@@ -8,9 +8,13 @@
 #include "systems/simple_render_system.hpp"
 #include "systems/point_light_system.hpp"
 #include "lve_buffer.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_staging_ring.hpp"
 #include <glm/glm.hpp>
 #include <array>
 #include <chrono>
+#include <filesystem>
+#include <iostream>
 #include <map>
 
 namespace lve {
@@ -18,16 +22,30 @@ namespace lve {
     const float X_OFFSET = 4.0f;  // Adjust as needed
     const float Y_OFFSET = -3.0f;  // Adjust as needed
 
+    // Texture bindings of the textures below, for .mtl materials whose map_Kd names one of them.
+    const std::map<std::string, int32_t> MATERIAL_TEXTURES = {
+            {"escamas.png", 1}, {"space.png", 2}, {"bluedragon.png", 3}, {"sky.png", 4}};
+    const uint32_t TEXTURE_COUNT = 4;
+    // Per frame in flight; the GlobalUbo takes under 1 KiB of it.
+    const VkDeviceSize FRAME_ALLOCATOR_BYTES = 64 * 1024;
+
     FirstApp::FirstApp() {
         // We need to add a pool for the textureImages.
         globalPool = LveDescriptorPool::Builder(lveDevice)
-                .setMaxSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, LveSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5 * LveSwapChain::MAX_FRAMES_IN_FLIGHT) // Adjusted for 5 textures
+                .setMaxSets(1 + TEXTURE_COUNT)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+                .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, TEXTURE_COUNT) // One set per texture
                 .build();
 
         loadGameObjects();
 
+        // One submission and one wait for all texture copies, layout transitions and mip blits.
+        startupUploads.flush();
+        std::cout << "Startup uploads: " << startupUploads.getStats().copies << " copies in "
+                  << startupUploads.getStats().submits << " submission, "
+                  << startupUploads.getStats().ownershipTransfers << " transfer queue handoffs, "
+                  << startupUploads.getStats().directWrites << " buffers written in place" << std::endl;
+
         // Ensure dragons' animations are not playing initially
         gameObjects.at(DRAGON1_ID).transform.isPlaying = false;
         gameObjects.at(DRAGON2_ID).transform.isPlaying = false;
@@ -55,47 +73,39 @@ namespace lve {
  */
     void FirstApp::run() {
 
-        std::vector<std::unique_ptr<LveBuffer>> uboBuffers(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i=0;i<uboBuffers.size();i++) {
-            uboBuffers[i] = std::make_unique<LveBuffer>(
-                    lveDevice,
-                    sizeof(GlobalUbo),
-                    1,
-                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
-            uboBuffers[i]->map();
-        }
+        // The GlobalUbo and any other per frame data come out of one ring of per frame regions.
+        // The global set points at the ring through a dynamic uniform buffer, so one set serves
+        // every frame and the UBO's offset is given at bind time.
+        LveFrameAllocator frameAllocator{lveDevice, FRAME_ALLOCATOR_BYTES};
 
         auto globalSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
-                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,VK_SHADER_STAGE_ALL_GRAPHICS)
-                .addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,VK_SHADER_STAGE_FRAGMENT_BIT)
-                .addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,VK_SHADER_STAGE_FRAGMENT_BIT) // Added 2nd texture
-                .addBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,VK_SHADER_STAGE_FRAGMENT_BIT) // Added 3rd texture
-                .addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,VK_SHADER_STAGE_FRAGMENT_BIT) // Added 4th texture
-                .addBinding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,VK_SHADER_STAGE_FRAGMENT_BIT) // Added 5th texture
+                .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,VK_SHADER_STAGE_ALL_GRAPHICS)
                 .build();
 
+        VkDescriptorSet globalDescriptorSet;
+        auto bufferInfo = frameAllocator.dynamicDescriptorInfo(sizeof(GlobalUbo));
+        LveDescriptorWriter(*globalSetLayout, *globalPool)
+                .writeBuffer(0, &bufferInfo)
+                .build(globalDescriptorSet);
 
-        std::vector<VkDescriptorSet> globalDescriptorSets(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
-        for (int i = 0; i < globalDescriptorSets.size(); i++) {
-            auto bufferInfo = uboBuffers[i]->descriptorInfo();
-            auto imageInfo1 = textureImage->descriptorImageInfo();
-            auto imageInfo2 = terrainTextureImage->descriptorImageInfo();  // Added
-            auto imageInfo3 = dinoTextureImage->descriptorImageInfo();      // Added
-            auto imageInfo4 = skyTextureImage->descriptorImageInfo();      // Added
-            auto imageInfo5 = skyTextureImage->descriptorImageInfo();      // Added
-            LveDescriptorWriter(*globalSetLayout, *globalPool)
-                    .writeBuffer(0, &bufferInfo)
-                    .writeImage(1, &imageInfo1)
-                    .writeImage(2, &imageInfo2)       // Added
-                    .writeImage(3, &imageInfo3)       // Added
-                    .writeImage(4, &imageInfo4)       // Added
-                    .writeImage(5, &imageInfo4)       // Added
-                    .build(globalDescriptorSets[i]);
+        // Textures are set 1, one set each so that draws sorted by texture share a bind.
+        // Indexed by texture binding, binding 0 draws vertex colors.
+        auto textureSetLayout = LveDescriptorSetLayout::Builder(lveDevice)
+                .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,VK_SHADER_STAGE_FRAGMENT_BIT)
+                .build();
+        std::vector<VkDescriptorSet> textureSets{VK_NULL_HANDLE};
+        for (const auto &texture : {textureImage, terrainTextureImage, dinoTextureImage, skyTextureImage}) {
+            auto imageInfo = texture->descriptorImageInfo();
+            textureSets.emplace_back();
+            LveDescriptorWriter(*textureSetLayout, *globalPool)
+                    .writeImage(0, &imageInfo)
+                    .build(textureSets.back());
         }
 
 
-        SimpleRenderSystem simpleRenderSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
+        SimpleRenderSystem simpleRenderSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout(),
+                                              textureSetLayout->getDescriptorSetLayout()};
+        simpleRenderSystem.setTextureSets(textureSets);
         PointLightSystem pointLightSystem{lveDevice, lveRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout()};
         LveCamera camera{};
         camera.setViewTarget(glm::vec3(0.f, 0.f, -2.5f), glm::vec3(0.f, 5.f, 1.5f));
@@ -109,6 +119,7 @@ namespace lve {
         KeyboardMovementController cameraController{};
 
         auto currentTime = std::chrono::high_resolution_clock::now();
+        float lodReportTime = 0.f;
 
         while (!lveWindow.shouldClose()) {
             glfwPollEvents();
@@ -116,6 +127,12 @@ namespace lve {
             float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
+            // Swap in models the streamer finished loading
+            modelStreamer.recordFrameTime(frameTime);
+            if (modelStreamer.update() > 0 && modelStreamer.isIdle()) {
+                printLoadSummary();
+            }
+
             // Update camera and aspect ratio
             cameraController.moveInPlaneXZ(lveWindow.getGLFWwindow(), frameTime, viewerObject);
             camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
@@ -147,28 +164,182 @@ namespace lve {
             camera.setPerspectiveProjection(glm::radians(30.f), aspect, 1.1f, 100.f);
             if (auto commandBuffer = lveRenderer.beginFrame()) {
                 int frameIndex = lveRenderer.getFrameIndex();
-                FrameInfo frameInfo{frameIndex, frameTime, commandBuffer,camera, globalDescriptorSets[frameIndex], gameObjects};
+                // beginFrame waited for this frame's fence, so its last round of data is free.
+                frameAllocator.beginFrame(frameIndex);
+                // Compact the geometry pool in frames where nothing is uploading into it.
+                if (modelStreamer.isIdle()) {
+                    uint32_t passes = geometryPool.getDefragmentStats().passes;
+                    geometryPool.defragment(commandBuffer);
+                    const auto &defragmentStats = geometryPool.getDefragmentStats();
+                    if (defragmentStats.passes != passes) {
+                        std::cout << "Geometry pool defragmented: " << defragmentStats.moves << " moves, "
+                                  << defragmentStats.bytesMoved / 1024 << " KiB in " << defragmentStats.frames
+                                  << " frames; fragmentation vertices " << defragmentStats.vertexFragmentationBefore
+                                  << " -> " << defragmentStats.vertexFragmentationAfter << ", indices "
+                                  << defragmentStats.indexFragmentationBefore << " -> "
+                                  << defragmentStats.indexFragmentationAfter << std::endl;
+                    }
+                }
+                auto uboSlice = frameAllocator.allocate(sizeof(GlobalUbo));
+                FrameInfo frameInfo{frameIndex, frameTime, commandBuffer,camera, globalDescriptorSet, gameObjects,
+                                    uboSlice.dynamicOffset(), frameAllocator};
                 //update
                 GlobalUbo ubo{};
                 ubo.projection = camera.getProjection();
                 ubo.view = camera.getView();
                 ubo.inverseView = camera.getInverseView();
                 pointLightSystem.update(frameInfo, ubo);
-                uboBuffers[frameIndex]->writeToBuffer(&ubo);
-                uboBuffers[frameIndex]->flush();
+                *static_cast<GlobalUbo *>(uboSlice.mapped) = ubo;
 
                 //render
                 lveRenderer.beginSwapChainRenderPass(commandBuffer);
                 simpleRenderSystem.render(frameInfo); // Solid Objects
                 // pointLightSystem.render(frameInfo);  // Transparent lights
                 lveRenderer.endSwapChainRenderPass(commandBuffer);
+                frameAllocator.flush();
                 lveRenderer.endFrame();
+
+                // Report what the LOD selection drew every few seconds
+                lodReportTime += frameTime;
+                if (lodReportTime > 5.f) {
+                    lodReportTime = 0.f;
+                    const auto &renderStats = simpleRenderSystem.getStats();
+                    std::cout << "LOD";
+                    for (size_t lod = 0; lod < renderStats.trianglesPerLod.size(); lod++) {
+                        std::cout << " " << lod << ": " << renderStats.objectsPerLod[lod] << " objects / "
+                                  << renderStats.trianglesPerLod[lod] << " triangles;";
+                    }
+                    const auto &meshletStats = renderStats.meshlets;
+                    if (meshletStats.trianglesTested > 0) {
+                        std::cout << " meshlets culled " << meshletStats.meshletsCulled << "/" << meshletStats.meshletsTested
+                                  << ", triangles rejected " << 100.0 * meshletStats.trianglesCulled / meshletStats.trianglesTested << "%";
+                    }
+                    std::cout << " buffer binds " << renderStats.bufferBinds << ", texture binds "
+                              << renderStats.textureBinds << ", draws " << renderStats.drawCalls;
+                    std::cout << std::endl;
+                    printMemoryBudget();
+                    printHostAllocations();
+                }
             }
         }
         vkDeviceWaitIdle(lveDevice.device());
     }
 
 
+/**
+ * Resolves the texture references of a model's .mtl materials to the app's texture bindings.
+ * Materials without a known map_Kd keep -1 and draw with their game object's texture.
+ */
+    void FirstApp::resolveMaterialTextures(LveModel &model) {
+        for (uint32_t i = 0; i < model.getMaterials().size(); i++) {
+            const auto &texture = model.getMaterials()[i].diffuseTexture;
+            if (texture.empty()) continue;
+            auto it = MATERIAL_TEXTURES.find(std::filesystem::path(texture).filename().string());
+            if (it != MATERIAL_TEXTURES.end()) {
+                model.setMaterialTexture(i, it->second);
+            }
+        }
+    }
+
+
+/**
+ * Prints how model loading went, once the streamer has finished the startup loads.
+ */
+    void FirstApp::printLoadSummary() {
+        // Cold loads parse the OBJ, warm loads are served from the binary mesh cache.
+        auto cacheStats = LveMeshCache::getStats();
+        std::cout << "Mesh cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+                  << cacheStats.writes << " writes";
+        if (cacheStats.misses > 0) std::cout << ", avg cold load " << cacheStats.coldLoadMs / cacheStats.misses << " ms";
+        if (cacheStats.hits > 0) std::cout << ", avg warm load " << cacheStats.warmLoadMs / cacheStats.hits << " ms";
+        std::cout << std::endl;
+
+        // Every planet shares one venus model, the registry loads each asset once.
+        const auto &registryStats = modelRegistry.getStats();
+        std::cout << "Model registry: " << registryStats.requests << " requests, " << registryStats.loads
+                  << " loads, " << registryStats.bytesSaved / 1024 << " KiB of GPU buffers and "
+                  << registryStats.loadMsSaved << " ms of loading saved" << std::endl;
+
+        const auto &streamStats = modelStreamer.getStats();
+        std::cout << "Model streaming: " << streamStats.loaded << " uploads, " << streamStats.failed << " failed, "
+                  << "longest upload frame " << streamStats.maxUploadMs << " ms; " << streamStats.spikeFrames << " of "
+                  << streamStats.streamingFrames << " frames while streaming over " << LveModelStreamer::SPIKE_FACTOR
+                  << "x the average of " << streamStats.averageFrameMs << " ms, worst " << streamStats.worstFrameMs
+                  << " ms" << std::endl;
+
+        auto poolStats = geometryPool.getStats();
+        std::cout << "Geometry pool: vertices " << poolStats.vertices.usedBytes / 1024 << "/"
+                  << poolStats.vertices.capacity / 1024 << " KiB in " << poolStats.vertices.allocations
+                  << " ranges, fragmentation " << poolStats.vertices.fragmentation() << "; indices "
+                  << poolStats.indices.usedBytes / 1024 << "/" << poolStats.indices.capacity / 1024 << " KiB in "
+                  << poolStats.indices.allocations << " ranges, fragmentation "
+                  << poolStats.indices.fragmentation() << std::endl;
+
+        auto stagingStats = lveDevice.stagingRing().getStats();
+        std::cout << "Staging ring: " << stagingStats.bytesStaged / (1024 * 1024) << " MiB in "
+                  << stagingStats.regions << " regions, peak " << stagingStats.peakBytesInUse / 1024 << "/"
+                  << stagingStats.capacity / 1024 << " KiB, " << stagingStats.fenceWaits << " fence waits"
+                  << std::endl;
+
+        auto memoryStats = lveDevice.memoryAllocator().getStats();
+        std::cout << "Device memory: " << memoryStats.allocations << " allocations in " << memoryStats.blocks
+                  << " blocks (" << memoryStats.dedicatedAllocations << " dedicated), "
+                  << memoryStats.requestedBytes / 1024 << "/" << memoryStats.blockBytes / 1024
+                  << " KiB, utilization " << memoryStats.utilization() << ", fragmentation "
+                  << memoryStats.fragmentation() << std::endl;
+    }
+
+
+/**
+ * Prints the device memory the scene uses: per heap against the budget, which the driver reports
+ * when VK_EXT_memory_budget is enabled and is estimated otherwise, and per category of resource.
+ */
+    void FirstApp::printMemoryBudget() {
+        constexpr uint64_t MiB = 1024 * 1024;
+        auto budget = lveDevice.memoryAllocator().getBudget();
+        std::cout << "Memory budget" << (budget.fromExtension ? "" : " (estimated)") << ":";
+        for (size_t heap = 0; heap < budget.heaps.size(); heap++) {
+            const auto &heapBudget = budget.heaps[heap];
+            if (heapBudget.blocks.peakBytes == 0) continue;
+            std::cout << " heap " << heap
+                      << (heapBudget.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? " (device local) " : " ")
+                      << heapBudget.usage / MiB << "/" << heapBudget.budget / MiB << " MiB, blocks "
+                      << heapBudget.blocks.bytes / MiB << " MiB peak " << heapBudget.blocks.peakBytes / MiB << ";";
+        }
+        for (uint32_t category = 0; category < LveMemoryAllocator::CATEGORY_COUNT; category++) {
+            const auto &usage = budget.categories[category];
+            if (usage.peakBytes == 0) continue;
+            std::cout << " " << LveMemoryAllocator::categoryName(static_cast<LveMemoryAllocator::Category>(category))
+                      << " " << usage.bytes / 1024 << " KiB peak " << usage.peakBytes / 1024 << " in "
+                      << usage.allocations << ";";
+        }
+        std::cout << std::endl;
+    }
+
+
+/**
+ * Prints how many host allocations the driver made per allocation scope since the last report,
+ * which finds vkCreate* calls and driver side allocations in the frame loop. Command scope
+ * allocations come from the host allocator's arena unless it overflowed.
+ */
+    void FirstApp::printHostAllocations() {
+        auto stats = lveDevice.hostAllocator().getStats();
+        std::cout << "Host allocations since last report:";
+        for (uint32_t scope = 0; scope < LveHostAllocator::SCOPE_COUNT; scope++) {
+            const auto &now = stats.scopes[scope];
+            const auto &last = lastHostStats.scopes[scope];
+            std::cout << " " << LveHostAllocator::scopeName(static_cast<VkSystemAllocationScope>(scope)) << " "
+                      << now.allocations - last.allocations;
+            if (now.arenaAllocations != last.arenaAllocations) {
+                std::cout << " (" << now.arenaAllocations - last.arenaAllocations << " arena)";
+            }
+            std::cout << " / " << (now.totalBytes - last.totalBytes) / 1024 << " KiB;";
+        }
+        std::cout << " live " << stats.liveBytes() / 1024 << " KiB" << std::endl;
+        lastHostStats = stats;
+    }
+
+
 /**
  * Loads all the game objects required for the scene.
  * This scene features dueling dragons, each with their own set of orbiting planets.
@@ -186,10 +357,25 @@ namespace lve {
  */
     void FirstApp::loadGameObjects() {
 
+        // Reorder every mesh for the post-transform vertex cache and less overdraw, and give
+        // distant objects simplified levels of detail
+        LveModel::LoadOptions modelOptions{};
+        modelOptions.optimizeVertexCache = true;
+        modelOptions.vertexFormat = LveModel::VertexFormat::Packed;
+        modelOptions.lodCount = 4;
+
+        // Models load in the background, objects draw the streamer's proxy cube until theirs is ready
+        auto streamModel = [this](LveGameObject &object, const std::string &filepath, const LveModel::LoadOptions &options) {
+            auto id = object.getId();
+            object.model = modelStreamer.loadAsync(filepath, options, [this, id](const std::shared_ptr<LveModel> &model) {
+                resolveMaterialTextures(*model);
+                gameObjects.at(id).model = model;
+            })->get();
+        };
+
         // Load the planet model and set its properties
-        std::shared_ptr<LveModel> lveModel = LveModel::createModelFromFile(lveDevice, "../models/venus.obj");
         LveGameObject planet = LveGameObject::createGameObject();
-        planet.model = lveModel;
+        streamModel(planet, "../models/venus.obj", modelOptions);
         planet.transform.isPlaying = true;
         planet.transform.translation = {-25.f, 5.f, -3.5f};
         planet.transform.scale = {1.f, 1.f, 1.f};
@@ -209,10 +395,11 @@ namespace lve {
         PLANET_ID = planet.getId();
         gameObjects.emplace(PLANET_ID, std::move(planet));
 
-        // Dragon 1
-        lveModel = LveModel::createModelFromFile(lveDevice, "../models/dragon.obj");
+        // Dragon 1, the dragon is closed and dense enough for back facing meshlets to be worth culling
+        LveModel::LoadOptions dragonOptions = modelOptions;
+        dragonOptions.buildMeshlets = true;
         LveGameObject dragon1 = LveGameObject::createGameObject();
-        dragon1.model = lveModel;
+        streamModel(dragon1, "../models/dragon.obj", dragonOptions);
         dragon1.transform.translation = {-23.f, 10.f, 2.5f};
         dragon1.transform.scale = {-1.f, -1.f, -1.f};
         dragon1.textureBinding = 1;
@@ -233,7 +420,7 @@ namespace lve {
 
         // Dragon 2
         LveGameObject dragon2 = LveGameObject::createGameObject();
-        dragon2.model = lveModel; // Reuse the model loaded for dragon 1
+        streamModel(dragon2, "../models/dragon.obj", dragonOptions); // Shares the model loaded for dragon 1
         dragon2.transform.translation = {-27.f, 0.f, 2.5f};
         dragon2.transform.scale = {1.f, 1.f, -1.f};
         dragon2.textureBinding = 3;
@@ -254,9 +441,8 @@ namespace lve {
 
 
         // Load the sky model and set its properties
-        lveModel = LveModel::createModelFromFile(lveDevice, "../models/sky.obj");
         auto sky = LveGameObject::createGameObject();
-        sky.model = lveModel;
+        streamModel(sky, "../models/sky.obj", modelOptions);
         sky.transform.translation = {50.0f, 45.0f, 30.0f};
         sky.transform.scale = {-50.f, -30.f, -30.f};
         sky.textureBinding = 4;
@@ -264,9 +450,8 @@ namespace lve {
 
         // Function to create and configure a planet
         auto createPlanet = [&](float x, float y, float z, int textureBind, float animDuration, TransformComponent* parentTransform) {
-            std::shared_ptr<LveModel> lveModelPlanet = LveModel::createModelFromFile(lveDevice, "../models/venus.obj");
             LveGameObject planet = LveGameObject::createGameObject();
-            planet.model = lveModelPlanet;
+            streamModel(planet, "../models/venus.obj", modelOptions);
             planet.transform.translation = {x, y, z};
             planet.transform.scale = {1.f, 1.f, 1.f};
             planet.textureBinding = textureBind;
@@ -300,7 +485,6 @@ namespace lve {
             gameObjects.emplace(planetId, std::move(planet));
         }
 
-
         // Define light colors
         std::map<int, glm::vec3> lightColorsMap{
                 {0, {.1f, .1f, 1.f}},  // Blue
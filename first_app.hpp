@@ -7,6 +7,10 @@
 #include "lve_renderer.hpp"
 #include "lve_descriptors.hpp"
 #include "lve_image.hpp"
+#include "lve_upload_batch.hpp"
+#include "lve_geometry_pool.hpp"
+#include "lve_model_registry.hpp"
+#include "lve_model_streamer.hpp"
 
 
 #include <memory>
@@ -49,25 +53,40 @@ namespace lve {
         glm::vec3 dragon2OriginalScale, dragon2TargetScale;
 
         void loadGameObjects();
+        void printLoadSummary();
+        // Device memory per heap against its budget and per category, every few seconds.
+        void printMemoryBudget();
+        // The driver's host allocations per scope since the last call.
+        void printHostAllocations();
+        // Points materials whose map_Kd names one of the app's textures at that texture.
+        void resolveMaterialTextures(LveModel &model);
         void animateDragon(int dragonId, bool& isAnimating, float frameTime);
 
         LveWindow lveWindow{WIDTH, HEIGHT, "Dueling Dragons!"};
         LveDevice lveDevice{lveWindow};
         LveRenderer lveRenderer{lveWindow, lveDevice};
+        // Models suballocate from one vertex / index buffer pair; declared before the users of it.
+        LveGeometryPool geometryPool{lveDevice};
+        LveModelRegistry modelRegistry{lveDevice, &geometryPool};
+        LveModelStreamer modelStreamer{lveDevice, modelRegistry};
         std::unique_ptr<LveDescriptorPool> globalPool{};
         LveGameObject::Map gameObjects;
+        LveHostAllocator::Stats lastHostStats{};
+
+        // The textures below record their uploads here; submitted once at the end of the constructor.
+        LveUploadBatch startupUploads{lveDevice};
 
         // Texture for dragon
-        std::shared_ptr<LveImage> textureImage = LveImage::createImageFromFile(lveDevice, "../textures/escamas.png");
+        std::shared_ptr<LveImage> textureImage = LveImage::createImageFromFile(lveDevice, "../textures/escamas.png", &startupUploads);
 
         // Texture for eaten planet
-        std::shared_ptr<LveImage> terrainTextureImage = LveImage::createImageFromFile(lveDevice, "../textures/space.png");
+        std::shared_ptr<LveImage> terrainTextureImage = LveImage::createImageFromFile(lveDevice, "../textures/space.png", &startupUploads);
 
         //Texture for blue dragon
-        std::shared_ptr<LveImage> dinoTextureImage = LveImage::createImageFromFile(lveDevice, "../textures/bluedragon.png");
+        std::shared_ptr<LveImage> dinoTextureImage = LveImage::createImageFromFile(lveDevice, "../textures/bluedragon.png", &startupUploads);
 
         //Texture for sky
-        std::shared_ptr<LveImage> skyTextureImage = LveImage::createImageFromFile(lveDevice, "../textures/sky.png");
+        std::shared_ptr<LveImage> skyTextureImage = LveImage::createImageFromFile(lveDevice, "../textures/sky.png", &startupUploads);
 
         std::vector<std::shared_ptr<LveImage>> textureImages; // For maintaining the list of textures
 
@@ -0,0 +1,205 @@
+#include "lve_bounds.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LVE_BOUNDS_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace lve {
+
+    namespace {
+
+        // Strided position access; the SSE path loads four floats per position, which is only
+        // safe to do past the last position when there is a stride of at least 16 bytes.
+        struct Positions {
+            const char *data;
+            size_t count;
+            size_t stride;
+
+            const glm::vec3 &operator[](size_t i) const {
+                return *reinterpret_cast<const glm::vec3 *>(data + i * stride);
+            }
+#ifdef LVE_BOUNDS_SSE
+            __m128 load(size_t i) const {
+                const auto *p = reinterpret_cast<const float *>(data + i * stride);
+                if (stride >= 4 * sizeof(float) || i + 1 < count) return _mm_loadu_ps(p);
+                return _mm_setr_ps(p[0], p[1], p[2], 0.f);
+            }
+#endif
+        };
+
+        // Box, plus the points with the smallest and largest coordinate on each axis.
+        void computeBox(const Positions &positions, glm::vec3 &minimum, glm::vec3 &maximum,
+                        size_t minimumPoint[3], size_t maximumPoint[3]) {
+            minimum = maximum = positions[0];
+            for (int axis = 0; axis < 3; axis++) minimumPoint[axis] = maximumPoint[axis] = 0;
+            size_t i = 1;
+#ifdef LVE_BOUNDS_SSE
+            __m128 low = positions.load(0);
+            __m128 high = low;
+            for (; i < positions.count; i++) {
+                __m128 p = positions.load(i);
+                // A new extreme is rare after the first few points, so the index bookkeeping
+                // stays off the hot path.
+                int changed = (_mm_movemask_ps(_mm_cmplt_ps(p, low)) | _mm_movemask_ps(_mm_cmpgt_ps(p, high))) & 7;
+                if (changed != 0) {
+                    const glm::vec3 &point = positions[i];
+                    for (int axis = 0; axis < 3; axis++) {
+                        if (point[axis] < minimum[axis]) minimum[axis] = point[axis], minimumPoint[axis] = i;
+                        if (point[axis] > maximum[axis]) maximum[axis] = point[axis], maximumPoint[axis] = i;
+                    }
+                    low = _mm_min_ps(low, p);
+                    high = _mm_max_ps(high, p);
+                }
+            }
+#else
+            for (; i < positions.count; i++) {
+                const glm::vec3 &point = positions[i];
+                for (int axis = 0; axis < 3; axis++) {
+                    if (point[axis] < minimum[axis]) minimum[axis] = point[axis], minimumPoint[axis] = i;
+                    if (point[axis] > maximum[axis]) maximum[axis] = point[axis], maximumPoint[axis] = i;
+                }
+            }
+#endif
+        }
+
+        // Moves the sphere just enough to take in point, if it is outside.
+        void growSphere(glm::vec3 &center, float &radius, const glm::vec3 &point) {
+            glm::vec3 offset = point - center;
+            float squaredDistance = glm::dot(offset, offset);
+            if (squaredDistance <= radius * radius) return;
+            float distance = std::sqrt(squaredDistance);
+            float grownRadius = 0.5f * (radius + distance);
+            center += offset * ((grownRadius - radius) / distance);
+            radius = grownRadius;
+        }
+
+        void ritterPass(const Positions &positions, glm::vec3 &center, float &radius) {
+            size_t i = 0;
+#ifdef LVE_BOUNDS_SSE
+            // Four points at a time against the current sphere; only a batch with a point outside
+            // falls back to the sequential update.
+            __m128 centerX = _mm_set1_ps(center.x), centerY = _mm_set1_ps(center.y), centerZ = _mm_set1_ps(center.z);
+            __m128 squaredRadius = _mm_set1_ps(radius * radius);
+            for (; i + 4 <= positions.count; i += 4) {
+                __m128 x = positions.load(i), y = positions.load(i + 1), z = positions.load(i + 2);
+                __m128 w = positions.load(i + 3);
+                _MM_TRANSPOSE4_PS(x, y, z, w);
+                __m128 dx = _mm_sub_ps(x, centerX), dy = _mm_sub_ps(y, centerY), dz = _mm_sub_ps(z, centerZ);
+                __m128 squaredDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                                    _mm_mul_ps(dz, dz));
+                if (_mm_movemask_ps(_mm_cmpgt_ps(squaredDistance, squaredRadius)) == 0) continue;
+
+                for (size_t j = i; j < i + 4; j++) growSphere(center, radius, positions[j]);
+                centerX = _mm_set1_ps(center.x), centerY = _mm_set1_ps(center.y), centerZ = _mm_set1_ps(center.z);
+                squaredRadius = _mm_set1_ps(radius * radius);
+            }
+#endif
+            for (; i < positions.count; i++) growSphere(center, radius, positions[i]);
+        }
+
+        float maxDistance(const Positions &positions, const glm::vec3 &center) {
+            float squaredMax = 0.f;
+            size_t i = 0;
+#ifdef LVE_BOUNDS_SSE
+            __m128 centerX = _mm_set1_ps(center.x), centerY = _mm_set1_ps(center.y), centerZ = _mm_set1_ps(center.z);
+            __m128 maximum = _mm_setzero_ps();
+            for (; i + 4 <= positions.count; i += 4) {
+                __m128 x = positions.load(i), y = positions.load(i + 1), z = positions.load(i + 2);
+                __m128 w = positions.load(i + 3);
+                _MM_TRANSPOSE4_PS(x, y, z, w);
+                __m128 dx = _mm_sub_ps(x, centerX), dy = _mm_sub_ps(y, centerY), dz = _mm_sub_ps(z, centerZ);
+                maximum = _mm_max_ps(maximum, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                                         _mm_mul_ps(dz, dz)));
+            }
+            alignas(16) float lanes[4];
+            _mm_store_ps(lanes, maximum);
+            squaredMax = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+            for (; i < positions.count; i++) {
+                glm::vec3 offset = positions[i] - center;
+                squaredMax = std::max(squaredMax, glm::dot(offset, offset));
+            }
+            return std::sqrt(squaredMax);
+        }
+
+        LveBounds computeBounds(const Positions &positions) {
+            LveBounds bounds{};
+            if (positions.count == 0) return bounds;
+
+            size_t minimumPoint[3], maximumPoint[3];
+            computeBox(positions, bounds.min, bounds.max, minimumPoint, maximumPoint);
+
+            // Seed with the axis whose extreme points are furthest apart.
+            glm::vec3 seedA{0.f}, seedB{0.f};
+            float seedDistance = -1.f;
+            for (int axis = 0; axis < 3; axis++) {
+                glm::vec3 a = positions[minimumPoint[axis]], b = positions[maximumPoint[axis]];
+                float distance = glm::dot(b - a, b - a);
+                if (distance > seedDistance) seedA = a, seedB = b, seedDistance = distance;
+            }
+            glm::vec3 center = 0.5f * (seedA + seedB);
+            float radius = 0.5f * std::sqrt(seedDistance);
+            ritterPass(positions, center, radius);
+
+            glm::vec3 boxCenter = 0.5f * (bounds.min + bounds.max);
+            float boxRadius = maxDistance(positions, boxCenter);
+            if (boxRadius < radius) {
+                center = boxCenter;
+                radius = boxRadius;
+            }
+            // Ritter's update leaves the new point on the sphere up to rounding.
+            bounds.center = center;
+            bounds.radius = radius * (1.f + 1e-5f);
+            return bounds;
+        }
+
+    }  // namespace
+
+    LveBounds LveBounds::transformed(const glm::mat4 &transform) const {
+        LveBounds result{};
+        glm::vec3 boxCenter = 0.5f * (min + max);
+        glm::vec3 halfExtent = 0.5f * (max - min);
+        glm::vec3 worldCenter{transform * glm::vec4{boxCenter, 1.f}};
+        glm::vec3 worldExtent{0.f};
+        for (int column = 0; column < 3; column++) {
+            for (int row = 0; row < 3; row++) {
+                worldExtent[row] += std::abs(transform[column][row]) * halfExtent[column];
+            }
+        }
+        result.min = worldCenter - worldExtent;
+        result.max = worldCenter + worldExtent;
+
+        float maxScale = std::max({glm::length(glm::vec3{transform[0]}), glm::length(glm::vec3{transform[1]}),
+                                   glm::length(glm::vec3{transform[2]})});
+        result.center = glm::vec3{transform * glm::vec4{center, 1.f}};
+        result.radius = radius * maxScale;
+        return result;
+    }
+
+    LveBounds LveBounds::compute(const glm::vec3 *positions, size_t count, size_t stride) {
+        return computeBounds({reinterpret_cast<const char *>(positions), count, stride});
+    }
+
+    LveBounds LveBounds::compute(const glm::vec3 *positions, size_t stride, const uint32_t *indices,
+                                 size_t indexCount) {
+        // Gather the referenced positions once each, padded to 16 bytes for the SSE loads.
+        std::vector<glm::vec4> gathered;
+        std::vector<bool> seen;
+        const auto *data = reinterpret_cast<const char *>(positions);
+        for (size_t i = 0; i < indexCount; i++) {
+            uint32_t index = indices[i];
+            if (index >= seen.size()) seen.resize(index + 1, false);
+            if (seen[index]) continue;
+            seen[index] = true;
+            gathered.emplace_back(*reinterpret_cast<const glm::vec3 *>(data + index * stride), 0.f);
+        }
+        return computeBounds({reinterpret_cast<const char *>(gathered.data()), gathered.size(), sizeof(glm::vec4)});
+    }
+
+}  // namespace lve
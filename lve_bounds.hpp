@@ -0,0 +1,40 @@
+#ifndef VULKANTEST_LVE_BOUNDS_HPP
+#define VULKANTEST_LVE_BOUNDS_HPP
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lve {
+
+    /**
+     * Axis aligned box and bounding sphere of a point set, for culling and picking.
+     *
+     * The sphere is grown with Ritter's algorithm from the most distant pair of axis extremes;
+     * if the sphere around the box center happens to be smaller (boxy shapes), that one is kept.
+     * Both the box and the sphere passes handle four points at a time with SSE where available.
+     */
+    struct LveBounds {
+        glm::vec3 min{0.f};
+        glm::vec3 max{0.f};
+        glm::vec3 center{0.f};  // of the sphere, not necessarily the box center
+        float radius = 0.f;
+
+        // Encloses the transformed box and sphere. The sphere radius grows by the largest scale
+        // of the transform, so it stays conservative under non-uniform scale.
+        LveBounds transformed(const glm::mat4 &transform) const;
+
+        // count positions starting at `positions`, stride bytes apart (e.g. vertices.data() cast
+        // to glm::vec3 and sizeof(Vertex)). All zero for count 0, positions may then be null.
+        static LveBounds compute(const glm::vec3 *positions, size_t count, size_t stride = sizeof(glm::vec3));
+        // Bounds of the positions referenced by indices[0, indexCount), each counted once.
+        static LveBounds compute(const glm::vec3 *positions, size_t stride, const uint32_t *indices,
+                                 size_t indexCount);
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_BOUNDS_HPP
@@ -48,12 +48,15 @@ namespace lve {
 
     LveBuffer::~LveBuffer() {
         unmap();
-        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
-        vkFreeMemory(lveDevice.device(), memory, nullptr);
+        lveDevice.deletionQueue().defer([&device = lveDevice, buffer = buffer, memory = memory]() mutable {
+            vkDestroyBuffer(device.device(), buffer, device.allocationCallbacks());
+            device.memoryAllocator().free(memory);
+        });
     }
 
 /**
  * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
+ * Host visible memory stays mapped by the allocator, so this only hands out the pointer.
  *
  * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
  * buffer range.
@@ -63,19 +66,23 @@ namespace lve {
  */
     VkResult LveBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
         assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(lveDevice.device(), memory, offset, size, 0, &mapped);
+        if (!memory.mapped) return VK_ERROR_MEMORY_MAP_FAILED;
+        mapped = static_cast<char *>(memory.mapped) + offset;
+        return VK_SUCCESS;
+    }
+
+    bool LveBuffer::isHostWritable() const {
+        return memory.mapped != nullptr &&
+               (lveDevice.memoryAllocator().getMemoryTypeFlags(memory.memoryType) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     }
 
 /**
  * Unmap a mapped memory range
  *
- * @note Does not return a result as vkUnmapMemory can't fail
+ * @note The block stays mapped for the other buffers in it, only this buffer's pointer is dropped
  */
     void LveBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(lveDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
 /**
@@ -113,9 +120,9 @@ namespace lve {
     VkResult LveBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = memory.memory;
+        mappedRange.offset = memory.offset + offset;
+        mappedRange.size = size == VK_WHOLE_SIZE ? memory.size - offset : size;
         return vkFlushMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
@@ -133,9 +140,9 @@ namespace lve {
     VkResult LveBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = memory.memory;
+        mappedRange.offset = memory.offset + offset;
+        mappedRange.size = size == VK_WHOLE_SIZE ? memory.size - offset : size;
         return vkInvalidateMappedMemoryRanges(lveDevice.device(), 1, &mappedRange);
     }
 
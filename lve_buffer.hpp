@@ -44,6 +44,9 @@ namespace lve {
         VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
         VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
         VkDeviceSize getBufferSize() const { return bufferSize; }
+        // Host visible and coherent memory, writable in place without a flush. On unified memory
+        // this includes device local buffers, see LveDevice::hasUnifiedMemory.
+        bool isHostWritable() const;
 
     private:
         static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
@@ -51,7 +54,7 @@ namespace lve {
         LveDevice& lveDevice;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        LveMemoryAllocator::Allocation memory{};
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -0,0 +1,74 @@
+#include "lve_deletion_queue.hpp"
+
+// std
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace lve {
+
+    LveDeletionQueue::~LveDeletionQueue() {
+        flush();
+    }
+
+    void LveDeletionQueue::defer(std::function<void()> destroy) {
+        std::lock_guard<std::mutex> lock{mutex};
+        entries.push_back({submittedFrames + 1, std::move(destroy)});
+        stats.deferred++;
+        stats.pending = static_cast<uint32_t>(entries.size());
+        stats.peakPending = std::max(stats.peakPending, stats.pending);
+    }
+
+    uint64_t LveDeletionQueue::currentFrame() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return submittedFrames + 1;
+    }
+
+    bool LveDeletionQueue::isComplete(uint64_t frame) const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return frame <= completedFrames;
+    }
+
+    void LveDeletionQueue::frameSubmitted() {
+        std::lock_guard<std::mutex> lock{mutex};
+        submittedFrames++;
+    }
+
+    void LveDeletionQueue::collect(uint64_t frame) {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            completedFrames = std::max(completedFrames, frame);
+        }
+        run(frame);
+    }
+
+    void LveDeletionQueue::flush() {
+        // Until no destruction defers anything more.
+        while (run(std::numeric_limits<uint64_t>::max()) > 0) {}
+    }
+
+    size_t LveDeletionQueue::run(uint64_t frame) {
+        // Destructions run outside the lock, they may defer more work or take other locks.
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            while (!entries.empty() && entries.front().frame <= frame) {
+                ready.push_back(std::move(entries.front().destroy));
+                entries.pop_front();
+            }
+            stats.destroyed += ready.size();
+            stats.pending = static_cast<uint32_t>(entries.size());
+        }
+        for (auto &destroy : ready) {
+            destroy();
+            destroy = nullptr;  // releases what the destruction captured, in order
+        }
+        return ready.size();
+    }
+
+    LveDeletionQueue::Stats LveDeletionQueue::getStats() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return stats;
+    }
+
+}  // namespace lve
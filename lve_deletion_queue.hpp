@@ -0,0 +1,72 @@
+#ifndef VULKANTEST_LVE_DELETION_QUEUE_HPP
+#define VULKANTEST_LVE_DELETION_QUEUE_HPP
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace lve {
+
+    /**
+     * Destroys resources once the frames that may still use them have finished on the device,
+     * so a buffer, image or model can be dropped in the middle of the render loop without a
+     * vkDeviceWaitIdle.
+     *
+     * Frames are numbered in submission order starting at 1. defer() tags the destruction with
+     * the frame being recorded (or the next one when none is): every frame that could have
+     * recorded the resource has that number or a lower one. LveRenderer reports submissions
+     * with frameSubmitted(), and calls collect() once it has waited for a frame's fence,
+     * which runs everything tagged with that frame or earlier.
+     *
+     * Owned by LveDevice. Thread safe; destructions run on the thread calling collect().
+     */
+    class LveDeletionQueue {
+    public:
+        struct Stats {
+            uint64_t deferred = 0;
+            uint64_t destroyed = 0;
+            uint32_t pending = 0;
+            uint32_t peakPending = 0;
+        };
+
+        LveDeletionQueue() = default;
+        ~LveDeletionQueue();
+
+        LveDeletionQueue(const LveDeletionQueue &) = delete;
+        LveDeletionQueue &operator=(const LveDeletionQueue &) = delete;
+
+        void defer(std::function<void()> destroy);
+
+        // The frame being recorded, or the next one to be.
+        uint64_t currentFrame() const;
+        bool isComplete(uint64_t frame) const;
+        void frameSubmitted();
+        // Every frame up to and including frame has finished on the device.
+        void collect(uint64_t frame);
+        // Runs every pending destruction. Only call it when the device is idle.
+        void flush();
+
+        Stats getStats() const;
+
+    private:
+        struct Entry {
+            uint64_t frame;
+            std::function<void()> destroy;
+        };
+
+        // Returns how many destructions ran.
+        size_t run(uint64_t frame);
+
+        mutable std::mutex mutex;
+        std::deque<Entry> entries;  // in frame order
+        uint64_t submittedFrames = 0;
+        uint64_t completedFrames = 0;
+        Stats stats{};
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_DELETION_QUEUE_HPP
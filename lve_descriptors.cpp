@@ -46,14 +46,14 @@ namespace lve {
         if (vkCreateDescriptorSetLayout(
                 lveDevice.device(),
                 &descriptorSetLayoutInfo,
-                nullptr,
+                lveDevice.allocationCallbacks(),
                 &descriptorSetLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor set layout!");
         }
     }
 
     LveDescriptorSetLayout::~LveDescriptorSetLayout() {
-        vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, lveDevice.allocationCallbacks());
     }
 
 // *************** Descriptor Pool Builder *********************
@@ -93,14 +93,14 @@ namespace lve {
         descriptorPoolInfo.maxSets = maxSets;
         descriptorPoolInfo.flags = poolFlags;
 
-        if (vkCreateDescriptorPool(lveDevice.device(), &descriptorPoolInfo, nullptr, &descriptorPool) !=
+        if (vkCreateDescriptorPool(lveDevice.device(), &descriptorPoolInfo, lveDevice.allocationCallbacks(), &descriptorPool) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor pool!");
         }
     }
 
     LveDescriptorPool::~LveDescriptorPool() {
-        vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+        vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, lveDevice.allocationCallbacks());
     }
 
     bool LveDescriptorPool::allocateDescriptorSet(
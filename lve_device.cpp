@@ -1,6 +1,8 @@
 #include "lve_device.hpp"
+#include "lve_staging_ring.hpp"
 
 // std headers
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -46,6 +48,10 @@ namespace lve {
         }
     }
 
+    // Memory that is both the GPU's own and writable from the host.
+    static constexpr VkMemoryPropertyFlags UNIFIED_MEMORY_PROPERTIES = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
 // class member functions
     LveDevice::LveDevice(LveWindow &window) : window{window} {
         createInstance();
@@ -53,19 +59,32 @@ namespace lve {
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        auto getMemoryProperties2 = memoryBudgetEnabled
+                ? (PFN_vkGetPhysicalDeviceMemoryProperties2KHR) vkGetInstanceProcAddr(
+                        instance, "vkGetPhysicalDeviceMemoryProperties2KHR")
+                : nullptr;
+        memoryAllocator_ = std::make_unique<LveMemoryAllocator>(physicalDevice, device_, allocationCallbacks(),
+                                                                getMemoryProperties2);
         createCommandPool();
+        stagingRing_ = std::make_unique<LveStagingRing>(*this);
     }
 
     LveDevice::~LveDevice() {
-        vkDestroyCommandPool(device_, commandPool, nullptr);
-        vkDestroyDevice(device_, nullptr);
+        stagingRing_.reset();
+        // Whatever is still queued may belong to the last frames.
+        vkDeviceWaitIdle(device_);
+        deletionQueue_.flush();
+        vkDestroyCommandPool(device_, transferCommandPool, allocationCallbacks());
+        vkDestroyCommandPool(device_, commandPool, allocationCallbacks());
+        memoryAllocator_.reset();
+        vkDestroyDevice(device_, allocationCallbacks());
 
         if (enableValidationLayers) {
-            DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+            DestroyDebugUtilsMessengerEXT(instance, debugMessenger, allocationCallbacks());
         }
 
         vkDestroySurfaceKHR(instance, surface_, nullptr);
-        vkDestroyInstance(instance, nullptr);
+        vkDestroyInstance(instance, allocationCallbacks());
     }
 
     void LveDevice::createInstance() {
@@ -86,6 +105,11 @@ namespace lve {
         createInfo.pApplicationInfo = &appInfo;
 
         auto extensions = getRequiredExtensions();
+        // Optional: VK_EXT_memory_budget reports through vkGetPhysicalDeviceMemoryProperties2KHR.
+        hasPhysicalDeviceProperties2 = checkInstanceExtensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (hasPhysicalDeviceProperties2) {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -101,7 +125,7 @@ namespace lve {
             createInfo.pNext = nullptr;
         }
 
-        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+        if (vkCreateInstance(&createInfo, allocationCallbacks(), &instance) != VK_SUCCESS) {
             throw std::runtime_error("failed to create instance!");
         }
 
@@ -131,13 +155,36 @@ namespace lve {
 
         vkGetPhysicalDeviceProperties(physicalDevice, &properties);
         std::cout << "physical device: " << properties.deviceName << std::endl;
+        detectUnifiedMemory();
+    }
+
+    void LveDevice::detectUnifiedMemory() {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+        // The largest device local heap is the GPU's memory. A host visible type on a smaller one
+        // is the 256 MiB BAR window of a discrete GPU, too small to hold all the geometry.
+        VkDeviceSize deviceHeapSize = 0;
+        for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+            if (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                deviceHeapSize = std::max(deviceHeapSize, memProperties.memoryHeaps[i].size);
+            }
+        }
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            const auto &type = memProperties.memoryTypes[i];
+            if ((type.propertyFlags & UNIFIED_MEMORY_PROPERTIES) == UNIFIED_MEMORY_PROPERTIES &&
+                memProperties.memoryHeaps[type.heapIndex].size >= deviceHeapSize) {
+                unifiedMemory = true;
+            }
+        }
+        std::cout << "unified memory: " << (unifiedMemory ? "yes, buffer uploads skip staging" : "no") << std::endl;
     }
 
     void LveDevice::createLogicalDevice() {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily: uniqueQueueFamilies) {
@@ -158,9 +205,30 @@ namespace lve {
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+        // VK_EXT_memory_budget is optional, LveMemoryAllocator estimates the budgets without it.
+        std::vector<const char *> enabledExtensions = deviceExtensions;
+        memoryBudgetEnabled = hasPhysicalDeviceProperties2 &&
+                              checkDeviceExtensionSupport(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (memoryBudgetEnabled) {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+#ifdef VK_EXT_host_image_copy
+        // VK_EXT_host_image_copy is optional too, LveImage stages its pixels without it.
+        VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+        hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+        hostImageCopyEnabled = checkHostImageCopySupport();
+        if (hostImageCopyEnabled) {
+            enabledExtensions.insert(enabledExtensions.end(), hostImageCopyExtensions.begin(),
+                                     hostImageCopyExtensions.end());
+            hostImageCopyFeatures.hostImageCopy = VK_TRUE;
+            createInfo.pNext = &hostImageCopyFeatures;
+        }
+#endif
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -171,12 +239,26 @@ namespace lve {
             createInfo.enabledLayerCount = 0;
         }
 
-        if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device_) != VK_SUCCESS) {
+        if (vkCreateDevice(physicalDevice, &createInfo, allocationCallbacks(), &device_) != VK_SUCCESS) {
             throw std::runtime_error("failed to create logical device!");
         }
 
+#ifdef VK_EXT_host_image_copy
+        if (hostImageCopyEnabled) {
+            transitionImageLayoutEXT = (PFN_vkTransitionImageLayoutEXT) vkGetDeviceProcAddr(
+                    device_, "vkTransitionImageLayoutEXT");
+            copyMemoryToImageEXT = (PFN_vkCopyMemoryToImageEXT) vkGetDeviceProcAddr(device_, "vkCopyMemoryToImageEXT");
+            hostImageCopyEnabled = transitionImageLayoutEXT != nullptr && copyMemoryToImageEXT != nullptr;
+        }
+#endif
+        std::cout << "host image copy: " << (hostImageCopyEnabled ? "yes, textures skip staging" : "no") << std::endl;
+
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+        queueFamilyIndices_ = indices;
+        std::cout << "transfer queue family: " << indices.transferFamily
+                  << (hasDedicatedTransferQueue() ? " (dedicated)" : " (shared with graphics)") << std::endl;
     }
 
     void LveDevice::createCommandPool() {
@@ -188,9 +270,15 @@ namespace lve {
         poolInfo.flags =
             VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        if (vkCreateCommandPool(device_, &poolInfo, allocationCallbacks(), &commandPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        poolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        if (vkCreateCommandPool(device_, &poolInfo, allocationCallbacks(), &transferCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create transfer command pool!");
+        }
     }
 
     void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
@@ -230,7 +318,7 @@ namespace lve {
         if (!enableValidationLayers) return;
         VkDebugUtilsMessengerCreateInfoEXT createInfo;
         populateDebugMessengerCreateInfo(createInfo);
-        if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
+        if (CreateDebugUtilsMessengerEXT(instance, &createInfo, allocationCallbacks(), &debugMessenger) != VK_SUCCESS) {
             throw std::runtime_error("failed to set up debug messenger!");
         }
     }
@@ -317,6 +405,78 @@ namespace lve {
         return requiredExtensions.empty();
     }
 
+    bool LveDevice::checkDeviceExtensionSupport(VkPhysicalDevice device, const char *extensionName) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto &extension: availableExtensions) {
+            if (strcmp(extension.extensionName, extensionName) == 0) return true;
+        }
+        return false;
+    }
+
+    bool LveDevice::checkInstanceExtensionSupport(const char *extensionName) {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+        for (const auto &extension: extensions) {
+            if (strcmp(extension.extensionName, extensionName) == 0) return true;
+        }
+        return false;
+    }
+
+#ifdef VK_EXT_host_image_copy
+    bool LveDevice::checkHostImageCopySupport() {
+        if (!hasPhysicalDeviceProperties2) return false;
+        for (const char *extension : hostImageCopyExtensions) {
+            if (!checkDeviceExtensionSupport(physicalDevice, extension)) return false;
+        }
+        auto getFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2KHR) vkGetInstanceProcAddr(
+                instance, "vkGetPhysicalDeviceFeatures2KHR");
+        auto getProperties2 = (PFN_vkGetPhysicalDeviceProperties2KHR) vkGetInstanceProcAddr(
+                instance, "vkGetPhysicalDeviceProperties2KHR");
+        auto getFormatProperties2 = (PFN_vkGetPhysicalDeviceFormatProperties2KHR) vkGetInstanceProcAddr(
+                instance, "vkGetPhysicalDeviceFormatProperties2KHR");
+        if (!getFeatures2 || !getProperties2 || !getFormatProperties2) return false;
+
+        VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures{};
+        hostImageCopyFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &hostImageCopyFeatures;
+        getFeatures2(physicalDevice, &features2);
+        if (!hostImageCopyFeatures.hostImageCopy) return false;
+
+        // The mip blits that follow the copy read and write TRANSFER_DST_OPTIMAL images.
+        VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties{};
+        hostImageCopyProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &hostImageCopyProperties;
+        getProperties2(physicalDevice, &properties2);
+        std::vector<VkImageLayout> copyDstLayouts(hostImageCopyProperties.copyDstLayoutCount);
+        hostImageCopyProperties.pCopyDstLayouts = copyDstLayouts.data();
+        getProperties2(physicalDevice, &properties2);
+        if (std::find(copyDstLayouts.begin(), copyDstLayouts.end(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) ==
+            copyDstLayouts.end()) {
+            return false;
+        }
+
+        // LveImage textures are RGBA8 sRGB with optimal tiling.
+        VkFormatProperties3 formatProperties3{};
+        formatProperties3.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3;
+        VkFormatProperties2 formatProperties2{};
+        formatProperties2.sType = VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2;
+        formatProperties2.pNext = &formatProperties3;
+        getFormatProperties2(physicalDevice, VK_FORMAT_R8G8B8A8_SRGB, &formatProperties2);
+        return (formatProperties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+    }
+#endif
+
     QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
 
@@ -345,6 +505,27 @@ namespace lve {
             i++;
         }
 
+        // Prefer a family that can only transfer (the copy engine on discrete GPUs), then any
+        // non graphics family that can; fall back to the graphics queue. Graphics and compute
+        // queues support transfers implicitly.
+        indices.transferFamily = indices.graphicsFamily;
+        int bestScore = 0;
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if (queueFamilies[family].queueCount == 0 || (flags & VK_QUEUE_GRAPHICS_BIT)) continue;
+            int score = 0;
+            if (flags & VK_QUEUE_COMPUTE_BIT) {
+                score = 1;
+            } else if (flags & VK_QUEUE_TRANSFER_BIT) {
+                score = 2;
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                indices.transferFamily = family;
+            }
+        }
+        indices.transferGranularity = queueFamilies[indices.transferFamily].minImageTransferGranularity;
+
         return indices;
     }
 
@@ -403,35 +584,51 @@ namespace lve {
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
+    bool LveDevice::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) &&
+                (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void LveDevice::createBuffer(
         VkDeviceSize size,
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer &buffer,
-        VkDeviceMemory &bufferMemory) {
+        LveMemoryAllocator::Allocation &bufferMemory) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        if (vkCreateBuffer(device_, &bufferInfo, allocationCallbacks(), &buffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to create vertex buffer!");
         }
 
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+        // On unified memory device local buffers can be host visible at no cost, which lets
+        // LveUploadBatch write them directly.
+        if (unifiedMemory && (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) &&
+            hasMemoryType(memRequirements.memoryTypeBits, properties | UNIFIED_MEMORY_PROPERTIES)) {
+            properties |= UNIFIED_MEMORY_PROPERTIES;
         }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+        bufferMemory = memoryAllocator_->allocate(
+            memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties),
+            LveMemoryAllocator::Kind::Linear, LveMemoryAllocator::bufferCategory(usage));
+
+        if (vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset) != VK_SUCCESS) {
+            throw std::runtime_error("failed to bind vertex buffer memory!");
+        }
     }
 
     VkCommandBuffer LveDevice::beginSingleTimeCommands() {
@@ -466,12 +663,12 @@ namespace lve {
         vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
     }
 
-    void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+    void LveDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset) {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
         VkBufferCopy copyRegion{};
         copyRegion.srcOffset = 0;  // Optional
-        copyRegion.dstOffset = 0;  // Optional
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -505,28 +702,70 @@ namespace lve {
         endSingleTimeCommands(commandBuffer);
     }
 
+    void LveDevice::copyMemoryToImage(VkImage image, const void *pixels, uint32_t width, uint32_t height,
+                                      uint32_t layerCount, uint32_t mipLevels) {
+#ifdef VK_EXT_host_image_copy
+        // The image isn't in use by the device yet, so the host can transition and write it.
+        VkHostImageLayoutTransitionInfoEXT transition{};
+        transition.sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT;
+        transition.image = image;
+        transition.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        transition.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        transition.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        transition.subresourceRange.baseMipLevel = 0;
+        transition.subresourceRange.levelCount = mipLevels;
+        transition.subresourceRange.baseArrayLayer = 0;
+        transition.subresourceRange.layerCount = layerCount;
+        if (transitionImageLayoutEXT(device_, 1, &transition) != VK_SUCCESS) {
+            throw std::runtime_error("failed to transition image layout on the host!");
+        }
+
+        VkMemoryToImageCopyEXT region{};
+        region.sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+        region.pHostPointer = pixels;
+        region.memoryRowLength = 0;
+        region.memoryImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+
+        VkCopyMemoryToImageInfoEXT copyInfo{};
+        copyInfo.sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT;
+        copyInfo.dstImage = image;
+        copyInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copyInfo.regionCount = 1;
+        copyInfo.pRegions = &region;
+        if (copyMemoryToImageEXT(device_, &copyInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to copy pixels to image!");
+        }
+#else
+        throw std::runtime_error("host image copy is not supported by these Vulkan headers!");
+#endif
+    }
+
     void LveDevice::createImageWithInfo(
         const VkImageCreateInfo &imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage &image,
-        VkDeviceMemory &imageMemory) {
-        if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        LveMemoryAllocator::Allocation &imageMemory) {
+        if (vkCreateImage(device_, &imageInfo, allocationCallbacks(), &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
 
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        // Linear tiled images share pages with buffers as freely as buffers do.
+        imageMemory = memoryAllocator_->allocate(
+            memRequirements, findMemoryType(memRequirements.memoryTypeBits, properties),
+            imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? LveMemoryAllocator::Kind::Linear
+                                                       : LveMemoryAllocator::Kind::Optimal,
+            LveMemoryAllocator::imageCategory(imageInfo.usage));
 
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
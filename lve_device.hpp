@@ -1,13 +1,19 @@
 #pragma once
 
+#include "lve_deletion_queue.hpp"
+#include "lve_host_allocator.hpp"
+#include "lve_memory_allocator.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+    class LveStagingRing;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -17,6 +23,10 @@ namespace lve {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;  // transfer only family if there is one, graphicsFamily otherwise
+        // Image copies on transferFamily must be aligned to this; (0,0,0) allows whole mips only.
+        // Graphics and compute families always report (1,1,1).
+        VkExtent3D transferGranularity{1, 1, 1};
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
 
@@ -54,6 +64,17 @@ namespace lve {
 
         VkQueue presentQueue() { return presentQueue_; }
 
+        // Staging uploads go through the transfer queue and its own pool so they can overlap
+        // rendering. Without a dedicated family these are the graphics queue and a second pool
+        // on it, and no ownership transfers are needed, see LveUploadBatch.
+        VkQueue transferQueue() { return transferQueue_; }
+
+        VkCommandPool getTransferCommandPool() { return transferCommandPool; }
+
+        bool hasDedicatedTransferQueue() { return queueFamilyIndices_.transferFamily != queueFamilyIndices_.graphicsFamily; }
+
+        const QueueFamilyIndices &queueFamilyIndices() { return queueFamilyIndices_; }
+
         VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
@@ -65,28 +86,60 @@ namespace lve {
         VkFormat findSupportedFormat(
                 const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
+        // Every buffer and image gets its memory from here; free it again with
+        // memoryAllocator().free after destroying the resource. createBuffer and
+        // createImageWithInfo tag the memory with a category from the usage flags.
+        LveMemoryAllocator &memoryAllocator() { return *memoryAllocator_; }
+
+        // Passed to every vkCreate* / vkDestroy*, so the driver's host allocations are counted.
+        const VkAllocationCallbacks *allocationCallbacks() const { return hostAllocator_.callbacks(); }
+        const LveHostAllocator &hostAllocator() const { return hostAllocator_; }
+
+        // Buffers and images destroy their Vulkan objects through here, once the frames that
+        // might still use them have finished.
+        LveDeletionQueue &deletionQueue() { return deletionQueue_; }
+
+        // Shared source memory for uploads, see LveUploadBatch::uploadBuffer.
+        LveStagingRing &stagingRing() { return *stagingRing_; }
+
+        // Device local memory the host can write as well, the whole of it and not just a BAR
+        // window: integrated and software GPUs (and resizable BAR). createBuffer then puts device
+        // local buffers there, and LveUploadBatch writes them in place instead of staging a copy.
+        bool hasUnifiedMemory() const { return unifiedMemory; }
+
+        // VK_EXT_host_image_copy is enabled: images with VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT can
+        // be filled by copyMemoryToImage, without a staging buffer. Always false when built with
+        // Vulkan headers older than 1.3.258, which don't have the extension.
+        bool hasHostImageCopy() const { return hostImageCopyEnabled; }
+
         // Buffer Helper Functions
         void createBuffer(
                 VkDeviceSize size,
                 VkBufferUsageFlags usage,
                 VkMemoryPropertyFlags properties,
                 VkBuffer &buffer,
-                VkDeviceMemory &bufferMemory);
+                LveMemoryAllocator::Allocation &bufferMemory);
 
         VkCommandBuffer beginSingleTimeCommands();
 
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
 
         void copyBufferToImage(
                 VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
+        // Host copy of tightly packed pixels into mip 0 of every layer. Leaves all mips in
+        // TRANSFER_DST_OPTIMAL like LveUploadBatch::uploadImage, ready for the mip blits. Only
+        // when hasHostImageCopy().
+        void copyMemoryToImage(VkImage image, const void *pixels, uint32_t width, uint32_t height,
+                               uint32_t layerCount, uint32_t mipLevels);
+
         void createImageWithInfo(
                 const VkImageCreateInfo &imageInfo,
                 VkMemoryPropertyFlags properties,
                 VkImage &image,
-                VkDeviceMemory &imageMemory);
+                LveMemoryAllocator::Allocation &imageMemory);
 
         VkPhysicalDeviceProperties properties;
 
@@ -103,6 +156,8 @@ namespace lve {
 
         void createCommandPool();
 
+        void detectUnifiedMemory();
+
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
 
@@ -118,21 +173,52 @@ namespace lve {
 
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 
+        bool checkDeviceExtensionSupport(VkPhysicalDevice device, const char *extensionName);
+
+        bool checkInstanceExtensionSupport(const char *extensionName);
+
+#ifdef VK_EXT_host_image_copy
+        bool checkHostImageCopySupport();
+#endif
+
+        bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
+        LveHostAllocator hostAllocator_;  // first, the instance is created and destroyed with it
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         LveWindow &window;
         VkCommandPool commandPool;
+        VkCommandPool transferCommandPool;
 
         VkDevice device_;
         VkSurfaceKHR surface_;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        QueueFamilyIndices queueFamilyIndices_;
+        bool hasPhysicalDeviceProperties2 = false;
+        bool memoryBudgetEnabled = false;
+        bool unifiedMemory = false;
+        bool hostImageCopyEnabled = false;
+#ifdef VK_EXT_host_image_copy
+        PFN_vkTransitionImageLayoutEXT transitionImageLayoutEXT = nullptr;
+        PFN_vkCopyMemoryToImageEXT copyMemoryToImageEXT = nullptr;
+#endif
+        std::unique_ptr<LveMemoryAllocator> memoryAllocator_;
+        LveDeletionQueue deletionQueue_;
+        std::unique_ptr<LveStagingRing> stagingRing_;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+#ifdef VK_EXT_host_image_copy
+        // VK_EXT_host_image_copy and what it requires on a Vulkan 1.0 instance.
+        const std::vector<const char *> hostImageCopyExtensions = {
+                VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME, VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME,
+                VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME};
+#endif
     };
 
 }  // namespace lve
\ No newline at end of file
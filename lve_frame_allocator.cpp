@@ -0,0 +1,64 @@
+#include "lve_frame_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    namespace {
+
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+    }  // namespace
+
+    LveFrameAllocator::LveFrameAllocator(LveDevice &device, VkDeviceSize bytesPerFrame, uint32_t frameCount) {
+        const auto &limits = device.properties.limits;
+        alignment = std::max({limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment,
+                              limits.nonCoherentAtomSize, VkDeviceSize{16}});
+        stats.bytesPerFrame = alignUp(bytesPerFrame, alignment);
+
+        buffer = std::make_unique<LveBuffer>(
+                device,
+                stats.bytesPerFrame,
+                frameCount,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        if (buffer->map() != VK_SUCCESS) {
+            throw std::runtime_error("failed to map frame allocator buffer!");
+        }
+    }
+
+    void LveFrameAllocator::beginFrame(int frameIndex) {
+        assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < buffer->getInstanceCount() &&
+               "Frame index out of range");
+        regionStart = head = flushed = stats.bytesPerFrame * frameIndex;
+        stats.usedBytes = 0;
+        stats.allocations = 0;
+    }
+
+    LveFrameAllocator::Slice LveFrameAllocator::allocate(VkDeviceSize size, VkDeviceSize sliceAlignment) {
+        VkDeviceSize offset = alignUp(head, sliceAlignment ? sliceAlignment : alignment);
+        if (offset + size > regionStart + stats.bytesPerFrame) {
+            throw std::runtime_error("frame allocator is out of space for this frame!");
+        }
+        head = offset + size;
+        stats.usedBytes = head - regionStart;
+        stats.peakBytes = std::max(stats.peakBytes, stats.usedBytes);
+        stats.allocations++;
+        return {buffer->getBuffer(), offset, size, static_cast<char *>(buffer->getMappedMemory()) + offset};
+    }
+
+    void LveFrameAllocator::flush() {
+        // Flushed ranges have to start and end on nonCoherentAtomSize, which alignment is a multiple of.
+        if (head == flushed) return;
+        VkDeviceSize start = flushed / alignment * alignment;
+        buffer->flush(alignUp(head, alignment) - start, start);
+        flushed = head;
+    }
+
+}  // namespace lve
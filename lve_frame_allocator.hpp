@@ -0,0 +1,81 @@
+#ifndef VULKANTEST_LVE_FRAME_ALLOCATOR_HPP
+#define VULKANTEST_LVE_FRAME_ALLOCATOR_HPP
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_swap_chain.hpp"
+
+// std
+#include <memory>
+
+namespace lve {
+
+    /**
+     * Transient per frame data (uniforms, instance data, debug vertices) without a buffer per use.
+     *
+     * One persistently mapped host visible buffer is split into a region per frame in flight.
+     * allocate() bumps an offset through the current frame's region; beginFrame() rewinds it
+     * once the frame's previous submission has finished, which LveRenderer::beginFrame has
+     * already waited for on the frame's fence.
+     *
+     * Slices are aligned for uniform and storage buffer offsets, so the buffer can sit behind a
+     * single *_DYNAMIC descriptor and every slice is selected with its offset as the dynamic
+     * offset at bind time.
+     */
+    class LveFrameAllocator {
+    public:
+        struct Slice {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            void *mapped = nullptr;
+
+            VkDescriptorBufferInfo descriptorInfo() const { return {buffer, offset, size}; }
+            uint32_t dynamicOffset() const { return static_cast<uint32_t>(offset); }
+        };
+
+        struct Stats {
+            VkDeviceSize bytesPerFrame = 0;
+            VkDeviceSize usedBytes = 0;  // by the current frame
+            VkDeviceSize peakBytes = 0;  // most any frame has used
+            uint32_t allocations = 0;    // by the current frame
+        };
+
+        LveFrameAllocator(LveDevice &device, VkDeviceSize bytesPerFrame,
+                          uint32_t frameCount = LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+        LveFrameAllocator(const LveFrameAllocator &) = delete;
+        LveFrameAllocator &operator=(const LveFrameAllocator &) = delete;
+
+        // Reclaims everything frameIndex allocated last time round. Only call it after the
+        // frame's fence has signalled.
+        void beginFrame(int frameIndex);
+        // alignment 0 uses the device's uniform / storage buffer offset alignment. Throws when
+        // the frame's region is full.
+        Slice allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+        template <typename T>
+        Slice push(const T &data) {
+            Slice slice = allocate(sizeof(T));
+            *static_cast<T *>(slice.mapped) = data;
+            return slice;
+        }
+        // Makes this frame's writes visible to the device; call before submitting the frame.
+        void flush();
+
+        VkBuffer getBuffer() const { return buffer->getBuffer(); }
+        // For a *_DYNAMIC descriptor: range bytes from the slice selected by the dynamic offset.
+        VkDescriptorBufferInfo dynamicDescriptorInfo(VkDeviceSize range) const { return {getBuffer(), 0, range}; }
+        const Stats &getStats() const { return stats; }
+
+    private:
+        VkDeviceSize alignment;  // default slice alignment, also of the frame regions
+        VkDeviceSize regionStart = 0;
+        VkDeviceSize head = 0;   // next free byte of the current frame's region
+        VkDeviceSize flushed = 0;
+        std::unique_ptr<LveBuffer> buffer;
+        Stats stats{};
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_FRAME_ALLOCATOR_HPP
@@ -6,6 +6,7 @@
 #define VULKANTEST_LVE_FRAME_INFO_HPP
 
 #include "lve_camera.hpp"
+#include "lve_frame_allocator.hpp"
 #include "lve_game_object.hpp"
 
 #include <vulkan/vulkan.h>
@@ -35,6 +36,8 @@ namespace lve {
         LveCamera &camera;
         VkDescriptorSet globalDescriptorSet;
         LveGameObject::Map &gameObjects;
+        uint32_t globalUboOffset;  // dynamic offset of this frame's GlobalUbo in globalDescriptorSet
+        LveFrameAllocator &frameAllocator;  // transient data for this frame only
     };
 }
 
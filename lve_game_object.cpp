@@ -36,6 +36,14 @@ namespace lve {
     }
 
 
+    LveBounds LveGameObject::getWorldBounds() {
+        if (model == nullptr) {
+            glm::vec3 position{transform.mat4()[3]};
+            return {position, position, position, 0.f};
+        }
+        return model->getBounds().transformed(transform.mat4());
+    }
+
     LveGameObject LveGameObject::makePointLight(float intensity, float radius, glm::vec3 color) {
         LveGameObject gameObj = LveGameObject::createGameObject();
         gameObj.color = color;
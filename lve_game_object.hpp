@@ -62,12 +62,17 @@ namespace lve {
 
         id_t getId() const { return id; }
 
+        // World space bounds of the model under transform.mat4(); a point at the translation
+        // for objects without a model.
+        LveBounds getWorldBounds();
+
 
         glm::vec3 color{};
         TransformComponent transform{};
         int32_t textureBinding = -1;
 
         std::shared_ptr<LveModel> model{};
+        uint32_t lodLevel = 0; // Level drawn last frame, SimpleRenderSystem only switches with hysteresis
         std::unique_ptr<PointLightComponent> pointLight = nullptr;
 
 
@@ -0,0 +1,165 @@
+#include "lve_geometry_pool.hpp"
+
+// std
+#include <algorithm>
+
+namespace lve {
+
+    LveGeometryPool::LveGeometryPool(LveDevice &device, VkDeviceSize vertexCapacity, VkDeviceSize indexCapacity)
+            : lveDevice{device}, vertexRanges{vertexCapacity}, indexRanges{indexCapacity} {
+        vertexBuffer = std::make_unique<LveBuffer>(
+                device,
+                1,
+                static_cast<uint32_t>(vertexCapacity),
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        indexBuffer = std::make_unique<LveBuffer>(
+                device,
+                1,
+                static_cast<uint32_t>(indexCapacity),
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+
+    bool LveGeometryPool::allocate(VkDeviceSize vertexBytes, VkDeviceSize vertexStride, VkDeviceSize indexBytes,
+                                   VkDeviceSize indexSize, Allocation &allocation, RelocateCallback onRelocate) {
+        reclaim();
+        VkDeviceSize vertexOffset = vertexRanges.allocate(vertexBytes, vertexStride);
+        if (vertexOffset == LveRangeAllocator::INVALID_OFFSET) return false;
+        VkDeviceSize indexOffset = indexRanges.allocate(indexBytes, indexSize);
+        if (indexOffset == LveRangeAllocator::INVALID_OFFSET) {
+            vertexRanges.free(vertexOffset, vertexBytes);
+            return false;
+        }
+        allocation = {vertexOffset, vertexBytes, indexOffset, indexBytes, nextId++};
+        live[allocation.id] = {allocation, vertexStride, indexSize, std::move(onRelocate)};
+        return true;
+    }
+
+    void LveGeometryPool::free(const Allocation &allocation) {
+        live.erase(allocation.id);
+        pendingFrees.emplace_back(lveDevice.deletionQueue().currentFrame(), allocation);
+    }
+
+    VkDeviceSize LveGeometryPool::compact(bool vertices, VkDeviceSize byteBudget, std::vector<VkBufferCopy> &copies,
+                                          std::vector<uint64_t> &moved) {
+        auto &ranges = vertices ? vertexRanges : indexRanges;
+        std::vector<Live *> candidates;
+        for (auto &entry : live) {
+            if (entry.second.onRelocate) candidates.push_back(&entry.second);
+        }
+        auto offsetOf = [vertices](const Live *entry) {
+            return vertices ? entry->allocation.vertexOffset : entry->allocation.indexOffset;
+        };
+        std::sort(candidates.begin(), candidates.end(),
+                  [&](const Live *a, const Live *b) { return offsetOf(a) > offsetOf(b); });
+
+        VkDeviceSize bytesMoved = 0;
+        for (Live *entry : candidates) {
+            VkDeviceSize &offset = vertices ? entry->allocation.vertexOffset : entry->allocation.indexOffset;
+            VkDeviceSize bytes = vertices ? entry->allocation.vertexBytes : entry->allocation.indexBytes;
+            if (bytes == 0 || bytesMoved + bytes > byteBudget) continue;
+            VkDeviceSize target = ranges.allocateBelow(bytes, vertices ? entry->vertexStride : entry->indexSize, offset);
+            if (target == LveRangeAllocator::INVALID_OFFSET) continue;
+
+            // The old range stays reserved for the frames in flight that still draw from it.
+            Allocation old{};
+            (vertices ? old.vertexOffset : old.indexOffset) = offset;
+            (vertices ? old.vertexBytes : old.indexBytes) = bytes;
+            pendingFrees.emplace_back(lveDevice.deletionQueue().currentFrame(), old);
+
+            copies.push_back({offset, target, bytes});
+            offset = target;
+            bytesMoved += bytes;
+            moved.push_back(entry->allocation.id);
+        }
+        return bytesMoved;
+    }
+
+    bool LveGeometryPool::defragment(VkCommandBuffer commandBuffer, VkDeviceSize byteBudget) {
+        reclaim();
+        auto &stats = defragmentStats;
+        if (!stats.active) {
+            stats.vertexFragmentationBefore = vertexRanges.getStats().fragmentation();
+            stats.indexFragmentationBefore = indexRanges.getStats().fragmentation();
+            // With all free space in one range per buffer, moving ranges gains nothing.
+            if (stats.vertexFragmentationBefore == 0.0f && stats.indexFragmentationBefore == 0.0f) return false;
+        }
+
+        std::vector<VkBufferCopy> vertexCopies;
+        std::vector<VkBufferCopy> indexCopies;
+        std::vector<uint64_t> moved;
+        VkDeviceSize bytesMoved = compact(true, byteBudget, vertexCopies, moved);
+        bytesMoved += compact(false, byteBudget - bytesMoved, indexCopies, moved);
+
+        if (bytesMoved == 0) {
+            // Finished once the last moves' old ranges have been reclaimed.
+            if (stats.active && pendingFrees.empty()) {
+                stats.active = false;
+                stats.passes++;
+                stats.vertexFragmentationAfter = vertexRanges.getStats().fragmentation();
+                stats.indexFragmentationAfter = indexRanges.getStats().fragmentation();
+            }
+            return stats.active;
+        }
+
+        // Source and destination ranges never overlap, so copies within one buffer are fine.
+        if (!vertexCopies.empty()) {
+            vkCmdCopyBuffer(commandBuffer, vertexBuffer->getBuffer(), vertexBuffer->getBuffer(),
+                            static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+        }
+        if (!indexCopies.empty()) {
+            vkCmdCopyBuffer(commandBuffer, indexBuffer->getBuffer(), indexBuffer->getBuffer(),
+                            static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+        }
+        // Later draws read the moved ranges, and so may a later pass's copies: a range moved this
+        // frame can move again next frame, while this frame is still in flight.
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        // An allocation moved in both buffers is reported once.
+        std::sort(moved.begin(), moved.end());
+        moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+        for (uint64_t id : moved) {
+            const Live &entry = live.at(id);
+            entry.onRelocate(entry.allocation);
+        }
+
+        if (!stats.active) {
+            stats.active = true;
+            stats.frames = 0;
+            stats.moves = 0;
+            stats.bytesMoved = 0;
+        }
+        stats.frames++;
+        stats.moves += static_cast<uint32_t>(vertexCopies.size() + indexCopies.size());
+        stats.bytesMoved += bytesMoved;
+        return true;
+    }
+
+    void LveGeometryPool::reclaim() {
+        auto &deletionQueue = lveDevice.deletionQueue();
+        auto done = std::stable_partition(pendingFrees.begin(), pendingFrees.end(), [&](const auto &pending) {
+            return !deletionQueue.isComplete(pending.first);
+        });
+        for (auto it = done; it != pendingFrees.end(); ++it) {
+            vertexRanges.free(it->second.vertexOffset, it->second.vertexBytes);
+            indexRanges.free(it->second.indexOffset, it->second.indexBytes);
+        }
+        pendingFrees.erase(done, pendingFrees.end());
+    }
+
+    void LveGeometryPool::bind(VkCommandBuffer commandBuffer, VkIndexType indexType) {
+        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
+    }
+
+}  // namespace lve
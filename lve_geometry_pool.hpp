@@ -0,0 +1,125 @@
+#ifndef VULKANTEST_LVE_GEOMETRY_POOL_HPP
+#define VULKANTEST_LVE_GEOMETRY_POOL_HPP
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_range_allocator.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * One device local vertex buffer and one index buffer that static models suballocate from.
+     *
+     * Models drawn from the pool share the buffer bindings, so a render loop only binds again
+     * when the index type changes; draws select their geometry with firstIndex / vertexOffset.
+     * Vertex ranges are aligned to the vertex stride and index ranges to the index size, which
+     * lets vertex formats and index types share the buffers.
+     *
+     * Freed ranges go back to the allocators once the frames that may still draw from them
+     * have finished, see LveDeletionQueue; until then they count as used.
+     *
+     * Streaming models in and out leaves the free space scattered until a large model no
+     * longer fits although enough is free. defragment() compacts the buffers a few ranges per
+     * frame: it copies the highest allocations into the lowest free ranges below them on the
+     * GPU and tells the owners their new offsets through the callback given to allocate().
+     */
+    class LveGeometryPool {
+    public:
+        static constexpr VkDeviceSize DEFAULT_VERTEX_CAPACITY = 64 * 1024 * 1024;
+        static constexpr VkDeviceSize DEFAULT_INDEX_CAPACITY = 32 * 1024 * 1024;
+
+        struct Allocation {
+            VkDeviceSize vertexOffset = 0;  // bytes
+            VkDeviceSize vertexBytes = 0;
+            VkDeviceSize indexOffset = 0;   // bytes
+            VkDeviceSize indexBytes = 0;
+            uint64_t id = 0;
+        };
+
+        // Receives the allocation's new offsets when defragment() moves it.
+        using RelocateCallback = std::function<void(const Allocation &allocation)>;
+
+        struct DefragmentStats {
+            bool active = false;      // a pass has moved ranges and not finished yet
+            uint32_t passes = 0;      // finished passes
+            // Of the current or last pass.
+            uint32_t frames = 0;      // defragment() calls that recorded copies
+            uint32_t moves = 0;       // ranges moved
+            uint64_t bytesMoved = 0;
+            // Before the current or last pass, and after the last one.
+            float vertexFragmentationBefore = 0.0f;
+            float indexFragmentationBefore = 0.0f;
+            float vertexFragmentationAfter = 0.0f;
+            float indexFragmentationAfter = 0.0f;
+        };
+
+        // A few tenths of a millisecond of copying on a discrete GPU.
+        static constexpr VkDeviceSize DEFAULT_DEFRAGMENT_BUDGET = 4 * 1024 * 1024;
+
+        struct Stats {
+            LveRangeAllocator::Stats vertices;
+            LveRangeAllocator::Stats indices;
+        };
+
+        LveGeometryPool(LveDevice &device, VkDeviceSize vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+                        VkDeviceSize indexCapacity = DEFAULT_INDEX_CAPACITY);
+
+        LveGeometryPool(const LveGeometryPool&) = delete;
+        LveGeometryPool &operator=(const LveGeometryPool&) = delete;
+
+        // Reserves both ranges or neither; false if the pool is too full. Only allocations with
+        // an onRelocate callback are moved by defragment().
+        bool allocate(VkDeviceSize vertexBytes, VkDeviceSize vertexStride, VkDeviceSize indexBytes,
+                      VkDeviceSize indexSize, Allocation &allocation, RelocateCallback onRelocate = {});
+        void free(const Allocation &allocation);
+
+        // Records copies of at most byteBudget bytes into commandBuffer, outside a render pass
+        // and before the draws that use the pool, and calls the owners' callbacks. Ranges larger
+        // than byteBudget stay where they are. Only call it while no upload into the pool is
+        // pending. Returns true while there is more to do.
+        bool defragment(VkCommandBuffer commandBuffer, VkDeviceSize byteBudget = DEFAULT_DEFRAGMENT_BUDGET);
+        const DefragmentStats &getDefragmentStats() const { return defragmentStats; }
+
+        void bind(VkCommandBuffer commandBuffer, VkIndexType indexType);
+
+        VkBuffer getVertexBuffer() const { return vertexBuffer->getBuffer(); }
+        VkBuffer getIndexBuffer() const { return indexBuffer->getBuffer(); }
+        // For LveUploadBatch::uploadBuffer, which writes the ranges in place on unified memory.
+        LveBuffer &getVertexStorage() { return *vertexBuffer; }
+        LveBuffer &getIndexStorage() { return *indexBuffer; }
+        Stats getStats() const { return {vertexRanges.getStats(), indexRanges.getStats()}; }
+
+    private:
+        struct Live {
+            Allocation allocation;
+            VkDeviceSize vertexStride;
+            VkDeviceSize indexSize;
+            RelocateCallback onRelocate;
+        };
+
+        void reclaim();
+        // Moves the highest ranges of one buffer down; returns the bytes moved.
+        VkDeviceSize compact(bool vertices, VkDeviceSize byteBudget, std::vector<VkBufferCopy> &copies,
+                             std::vector<uint64_t> &moved);
+
+        LveDevice &lveDevice;
+        std::vector<std::pair<uint64_t, Allocation>> pendingFrees;  // with the frame that freed them
+        std::unordered_map<uint64_t, Live> live;
+        uint64_t nextId = 1;
+        DefragmentStats defragmentStats{};
+        std::unique_ptr<LveBuffer> vertexBuffer;
+        std::unique_ptr<LveBuffer> indexBuffer;
+        LveRangeAllocator vertexRanges;
+        LveRangeAllocator indexRanges;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_GEOMETRY_POOL_HPP
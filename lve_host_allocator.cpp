@@ -0,0 +1,192 @@
+#include "lve_host_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace lve {
+
+    namespace {
+
+        // Stored in front of every allocation, so frees and reallocations know where it came from.
+        struct Header {
+            size_t size;
+            uint32_t scope;
+            uint32_t fromArena;
+            void *base;  // the malloc'd block, or the Arena
+        };
+
+        struct Arena {
+            std::unique_ptr<char[]> memory;
+            size_t size = 0;
+            size_t head = 0;
+            uint32_t live = 0;
+        };
+
+        thread_local Arena arena;
+
+        Header readHeader(const void *memory) {
+            Header header;
+            std::memcpy(&header, static_cast<const char *>(memory) - sizeof(Header), sizeof(Header));
+            return header;
+        }
+
+        // Alignment may be as low as 1, so the header isn't necessarily aligned.
+        char *place(char *start, size_t alignment, const Header &header) {
+            auto address = reinterpret_cast<uintptr_t>(start) + sizeof(Header);
+            address = (address + alignment - 1) / alignment * alignment;
+            char *memory = reinterpret_cast<char *>(address);
+            std::memcpy(memory - sizeof(Header), &header, sizeof(Header));
+            return memory;
+        }
+
+        void raisePeak(std::atomic<uint64_t> &peak, uint64_t value) {
+            uint64_t current = peak.load(std::memory_order_relaxed);
+            while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+        }
+
+    }  // namespace
+
+    uint64_t LveHostAllocator::Stats::allocations() const {
+        uint64_t count = 0;
+        for (const auto &scope : scopes) count += scope.allocations;
+        return count;
+    }
+
+    uint64_t LveHostAllocator::Stats::liveBytes() const {
+        uint64_t bytes = 0;
+        for (const auto &scope : scopes) bytes += scope.liveBytes + scope.internalBytes;
+        return bytes;
+    }
+
+    const char *LveHostAllocator::scopeName(VkSystemAllocationScope scope) {
+        switch (scope) {
+            case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return "command";
+            case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return "object";
+            case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return "cache";
+            case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return "device";
+            case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "instance";
+            default: return "unknown";
+        }
+    }
+
+    LveHostAllocator::LveHostAllocator(bool commandArena, size_t arenaSize)
+            : commandArena{commandArena}, arenaSize{arenaSize} {
+        allocationCallbacks.pUserData = this;
+        allocationCallbacks.pfnAllocation = allocationFunction;
+        allocationCallbacks.pfnReallocation = reallocationFunction;
+        allocationCallbacks.pfnFree = freeFunction;
+        allocationCallbacks.pfnInternalAllocation = internalAllocationNotification;
+        allocationCallbacks.pfnInternalFree = internalFreeNotification;
+    }
+
+    void *LveHostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope) {
+        if (size == 0) return nullptr;
+        alignment = std::max<size_t>(alignment, 1);
+        uint32_t scopeIndex = std::min<uint32_t>(scope, SCOPE_COUNT - 1);
+        Counters &counter = counters[scopeIndex];
+        Header header{size, scopeIndex, 0, nullptr};
+        size_t needed = size + sizeof(Header) + alignment - 1;
+
+        char *memory = nullptr;
+        if (commandArena && scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+            if (!arena.memory) {
+                arena.memory = std::make_unique<char[]>(arenaSize);
+                arena.size = arenaSize;
+            }
+            if (arena.head + needed <= arena.size) {
+                header.fromArena = 1;
+                header.base = &arena;
+                memory = place(arena.memory.get() + arena.head, alignment, header);
+                arena.head = (memory - arena.memory.get()) + size;
+                arena.live++;
+                counter.arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (memory == nullptr) {
+            char *block = static_cast<char *>(std::malloc(needed));
+            if (block == nullptr) return nullptr;
+            header.base = block;
+            memory = place(block, alignment, header);
+        }
+
+        counter.allocations.fetch_add(1, std::memory_order_relaxed);
+        counter.totalBytes.fetch_add(size, std::memory_order_relaxed);
+        raisePeak(counter.peakBytes, counter.liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+        return memory;
+    }
+
+    void *LveHostAllocator::reallocate(void *original, size_t size, size_t alignment,
+                                       VkSystemAllocationScope scope) {
+        if (original == nullptr) return allocate(size, alignment, scope);
+        if (size == 0) {
+            free(original);
+            return nullptr;
+        }
+        void *memory = allocate(size, alignment, scope);
+        if (memory == nullptr) return nullptr;  // the original stays valid
+        std::memcpy(memory, original, std::min(size, readHeader(original).size));
+        free(original);
+        return memory;
+    }
+
+    void LveHostAllocator::free(void *memory) {
+        if (memory == nullptr) return;
+        Header header = readHeader(memory);
+        Counters &counter = counters[header.scope];
+        counter.frees.fetch_add(1, std::memory_order_relaxed);
+        counter.liveBytes.fetch_sub(header.size, std::memory_order_relaxed);
+        if (header.fromArena) {
+            // Command scope allocations are freed within the call, on the allocating thread.
+            auto *owner = static_cast<Arena *>(header.base);
+            if (--owner->live == 0) owner->head = 0;
+        } else {
+            std::free(header.base);
+        }
+    }
+
+    void *LveHostAllocator::allocationFunction(void *userData, size_t size, size_t alignment,
+                                               VkSystemAllocationScope scope) {
+        return static_cast<LveHostAllocator *>(userData)->allocate(size, alignment, scope);
+    }
+
+    void *LveHostAllocator::reallocationFunction(void *userData, void *original, size_t size, size_t alignment,
+                                                 VkSystemAllocationScope scope) {
+        return static_cast<LveHostAllocator *>(userData)->reallocate(original, size, alignment, scope);
+    }
+
+    void LveHostAllocator::freeFunction(void *userData, void *memory) {
+        static_cast<LveHostAllocator *>(userData)->free(memory);
+    }
+
+    void LveHostAllocator::internalAllocationNotification(void *userData, size_t size, VkInternalAllocationType,
+                                                          VkSystemAllocationScope scope) {
+        auto *allocator = static_cast<LveHostAllocator *>(userData);
+        allocator->counters[std::min<uint32_t>(scope, SCOPE_COUNT - 1)].internalBytes.fetch_add(size);
+    }
+
+    void LveHostAllocator::internalFreeNotification(void *userData, size_t size, VkInternalAllocationType,
+                                                    VkSystemAllocationScope scope) {
+        auto *allocator = static_cast<LveHostAllocator *>(userData);
+        allocator->counters[std::min<uint32_t>(scope, SCOPE_COUNT - 1)].internalBytes.fetch_sub(size);
+    }
+
+    LveHostAllocator::Stats LveHostAllocator::getStats() const {
+        Stats stats{};
+        for (uint32_t scope = 0; scope < SCOPE_COUNT; scope++) {
+            const Counters &counter = counters[scope];
+            auto &scopeStats = stats.scopes[scope];
+            scopeStats.allocations = counter.allocations.load(std::memory_order_relaxed);
+            scopeStats.frees = counter.frees.load(std::memory_order_relaxed);
+            scopeStats.arenaAllocations = counter.arenaAllocations.load(std::memory_order_relaxed);
+            scopeStats.liveBytes = counter.liveBytes.load(std::memory_order_relaxed);
+            scopeStats.peakBytes = counter.peakBytes.load(std::memory_order_relaxed);
+            scopeStats.totalBytes = counter.totalBytes.load(std::memory_order_relaxed);
+            scopeStats.internalBytes = counter.internalBytes.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+}  // namespace lve
@@ -0,0 +1,93 @@
+#ifndef VULKANTEST_LVE_HOST_ALLOCATOR_HPP
+#define VULKANTEST_LVE_HOST_ALLOCATOR_HPP
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lve {
+
+    /**
+     * VkAllocationCallbacks that count the driver's host allocations, so host allocation churn
+     * in the frame loop shows up in the stats output.
+     *
+     * Counters are kept per VkSystemAllocationScope; driver internal allocations reported
+     * through the notification callbacks are counted separately. With the command arena
+     * enabled, VK_SYSTEM_ALLOCATION_SCOPE_COMMAND allocations, which only live for the duration
+     * of one Vulkan call, are bumped out of a per thread arena that rewinds whenever its last
+     * allocation is freed. Allocations that don't fit fall back to the heap.
+     *
+     * Owned by LveDevice, which passes callbacks() to every vkCreate* / vkDestroy* call. Thread safe.
+     */
+    class LveHostAllocator {
+    public:
+        static constexpr size_t DEFAULT_ARENA_SIZE = 256 * 1024;
+        static constexpr uint32_t SCOPE_COUNT = 5;  // VK_SYSTEM_ALLOCATION_SCOPE_COMMAND .. _INSTANCE
+
+        struct ScopeStats {
+            uint64_t allocations = 0;       // allocations and reallocations
+            uint64_t frees = 0;
+            uint64_t arenaAllocations = 0;  // served by the command arena
+            uint64_t liveBytes = 0;
+            uint64_t peakBytes = 0;
+            uint64_t totalBytes = 0;        // allocated over the lifetime
+            uint64_t internalBytes = 0;     // live driver internal allocations
+        };
+
+        struct Stats {
+            std::array<ScopeStats, SCOPE_COUNT> scopes{};
+            uint64_t allocations() const;
+            uint64_t liveBytes() const;
+        };
+
+        static const char *scopeName(VkSystemAllocationScope scope);
+
+        explicit LveHostAllocator(bool commandArena = true, size_t arenaSize = DEFAULT_ARENA_SIZE);
+
+        LveHostAllocator(const LveHostAllocator &) = delete;
+        LveHostAllocator &operator=(const LveHostAllocator &) = delete;
+
+        const VkAllocationCallbacks *callbacks() const { return &allocationCallbacks; }
+        Stats getStats() const;
+
+    private:
+        struct Counters {
+            std::atomic<uint64_t> allocations{0};
+            std::atomic<uint64_t> frees{0};
+            std::atomic<uint64_t> arenaAllocations{0};
+            std::atomic<uint64_t> liveBytes{0};
+            std::atomic<uint64_t> peakBytes{0};
+            std::atomic<uint64_t> totalBytes{0};
+            std::atomic<uint64_t> internalBytes{0};
+        };
+
+        // The VkAllocationCallbacks entry points; userData is the allocator.
+        static VKAPI_ATTR void *VKAPI_CALL allocationFunction(void *userData, size_t size, size_t alignment,
+                                                              VkSystemAllocationScope scope);
+        static VKAPI_ATTR void *VKAPI_CALL reallocationFunction(void *userData, void *original, size_t size,
+                                                                size_t alignment, VkSystemAllocationScope scope);
+        static VKAPI_ATTR void VKAPI_CALL freeFunction(void *userData, void *memory);
+        static VKAPI_ATTR void VKAPI_CALL internalAllocationNotification(void *userData, size_t size,
+                                                                         VkInternalAllocationType type,
+                                                                         VkSystemAllocationScope scope);
+        static VKAPI_ATTR void VKAPI_CALL internalFreeNotification(void *userData, size_t size,
+                                                                   VkInternalAllocationType type,
+                                                                   VkSystemAllocationScope scope);
+
+        void *allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void *reallocate(void *original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+        void free(void *memory);
+
+        bool commandArena;
+        size_t arenaSize;
+        VkAllocationCallbacks allocationCallbacks{};
+        std::array<Counters, SCOPE_COUNT> counters;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_HOST_ALLOCATOR_HPP
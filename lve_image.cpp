@@ -11,14 +11,28 @@
 
 namespace lve {
 
-    LveImage::LveImage(LveDevice &device, uint32_t w, uint32_t h, LveBuffer &imageBuffer) :
+    LveImage::LveImage(LveDevice &device, uint32_t w, uint32_t h, const void *pixels, LveUploadBatch *batch) :
         lveDevice{device}, width{w}, height{h} {
         mipLevels = static_cast<uint32_t >(std::floor(std::log2(std::max(width,height))))+1;
-        createImage(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        transitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        lveDevice.copyBufferToImage(imageBuffer.getBuffer(), image, static_cast<uint32_t>(width), static_cast<uint32_t>(height),arrayLayers);
-       // transitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        generateMipmaps();
+        // With VK_EXT_host_image_copy the host writes mip 0 itself, nothing is staged.
+        bool hostCopy = lveDevice.hasHostImageCopy();
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+#ifdef VK_EXT_host_image_copy
+        if (hostCopy) usage |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+#endif
+        createImage(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        // Transition, copy and mip blits go out in one submission instead of three round trips. The
+        // batch records the transition with the copy, on the transfer queue if there is one.
+        LveUploadBatch ownBatch{lveDevice};
+        LveUploadBatch &upload = batch ? *batch : ownBatch;
+        if (hostCopy) {
+            lveDevice.copyMemoryToImage(image, pixels, width, height, arrayLayers, mipLevels);
+        } else {
+            upload.uploadImage(image, pixels, width, height, sizeof(uint32_t), arrayLayers, mipLevels);
+        }
+        generateMipmaps(upload.getCommandBuffer());
+        ownBatch.flush();
         // Don't need the imageBuffer anymore here.
         // Order of these two does not seem to matter.
         createImageView(VK_FORMAT_R8G8B8A8_SRGB);
@@ -26,10 +40,13 @@ namespace lve {
     }
 
     LveImage::~LveImage() {
-        vkDestroySampler(lveDevice.device(), textureSampler, nullptr);
-        vkDestroyImageView(lveDevice.device(), imageView, nullptr);
-        vkDestroyImage(lveDevice.device(), image, nullptr);
-        vkFreeMemory(lveDevice.device(), imageMemory, nullptr);
+        lveDevice.deletionQueue().defer([&device = lveDevice, sampler = textureSampler, view = imageView,
+                                         image = image, memory = imageMemory]() mutable {
+            vkDestroySampler(device.device(), sampler, device.allocationCallbacks());
+            vkDestroyImageView(device.device(), view, device.allocationCallbacks());
+            vkDestroyImage(device.device(), image, device.allocationCallbacks());
+            device.memoryAllocator().free(memory);
+        });
     }
 
     VkDescriptorImageInfo LveImage::descriptorImageInfo() {
@@ -67,77 +84,19 @@ namespace lve {
         lveDevice.createImageWithInfo(imageInfo, properties,image,imageMemory);
     }
 
-    std::unique_ptr<LveImage> LveImage::createImageFromFile(LveDevice &lveDevice, const std::string &filepath) {
+    std::unique_ptr<LveImage> LveImage::createImageFromFile(LveDevice &lveDevice, const std::string &filepath,
+                                                            LveUploadBatch *batch) {
         int texWidth, texHeight, texChannels;
         stbi_uc *pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-        uint32_t pixelCount = texWidth * texHeight;
-        uint32_t pixelSize = sizeof(uint32_t);
 
         if (!pixels) {
             throw std::runtime_error("failed to load texture image!");
         }
 
-        LveBuffer imgBuffer = LveBuffer{
-        lveDevice,
-            pixelSize,
-            pixelCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-         };
-
-        imgBuffer.map();
-        imgBuffer.writeToBuffer(pixels);
-
+        // The pixels are copied into the staging ring (or the image) right away.
+        auto lveImage = std::make_unique<LveImage>(lveDevice, texWidth, texHeight, pixels, batch);
         stbi_image_free(pixels);
-
-        return std::make_unique<LveImage>(lveDevice, texWidth, texHeight, imgBuffer);;
-    }
-
-    void LveImage::transitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
-        VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
-
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = oldLayout;
-        barrier.newLayout = newLayout;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = mipLevels;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
-
-        VkPipelineStageFlags sourceStage;
-        VkPipelineStageFlags destinationStage;
-
-        if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        } else {
-            throw std::invalid_argument("unsupported layout transition!");
-        }
-
-        vkCmdPipelineBarrier(
-                commandBuffer,
-                sourceStage, destinationStage,
-                0,
-                0, nullptr,
-                0, nullptr,
-                1, &barrier
-        );
-
-        lveDevice.endSingleTimeCommands(commandBuffer);
+        return lveImage;
     }
 
     void LveImage::createImageView(VkFormat format) {
@@ -152,7 +111,7 @@ namespace lve {
         viewInfo.subresourceRange.baseArrayLayer = 0;
         viewInfo.subresourceRange.layerCount = 1; //array layers
 
-        if (vkCreateImageView(lveDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+        if (vkCreateImageView(lveDevice.device(), &viewInfo, lveDevice.allocationCallbacks(), &imageView) != VK_SUCCESS) {
             throw std::runtime_error("failed to create texture image view!");
         }
     }
@@ -174,12 +133,12 @@ namespace lve {
         samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 
         //std::cout << "max sampler anisotropy: " << lveDevice.properties.limits.maxSamplerAnisotropy << std::endl;
-        if (vkCreateSampler(lveDevice.device(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
+        if (vkCreateSampler(lveDevice.device(), &samplerInfo, lveDevice.allocationCallbacks(), &textureSampler) != VK_SUCCESS) {
             throw std::runtime_error("failed to create texture sampler!");
         }
     }
 
-    void LveImage::generateMipmaps() {
+    void LveImage::generateMipmaps(VkCommandBuffer commandBuffer) {
         VkFormatProperties formatProperties;
         VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB; // One approach has this as an instance variable.
         vkGetPhysicalDeviceFormatProperties(lveDevice.getPhysicalDevice(), imageFormat, &formatProperties);
@@ -188,8 +147,6 @@ namespace lve {
             throw std::runtime_error("texture image format does not support linear blitting!");
         }
 
-        VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
-
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
         barrier.image = image;
@@ -246,8 +203,6 @@ namespace lve {
         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
         vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-        lveDevice.endSingleTimeCommands(commandBuffer);
     }
 
 
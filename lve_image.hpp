@@ -8,6 +8,7 @@
 #include "lve_buffer.hpp"
 #include "lve_window.hpp"
 #include "lve_device.hpp"
+#include "lve_upload_batch.hpp"
 
 #include <memory>
 
@@ -16,28 +17,32 @@ namespace lve {
         class LveImage {
         public:
 
-            LveImage(LveDevice &device, uint32_t width, uint32_t height, LveBuffer &imgBuffer);
+            // Records the upload of the RGBA8 pixels and mip generation into batch, or submits and
+            // waits on its own without one. The pixels are staged, or copied into the image with
+            // host image copy, before the constructor returns.
+            LveImage(LveDevice &device, uint32_t width, uint32_t height, const void *pixels,
+                     LveUploadBatch *batch = nullptr);
             ~LveImage();
 
             LveImage(const LveImage&) = delete;
             LveImage &operator=(const LveImage&) = delete;
 
-            static std::unique_ptr<LveImage> createImageFromFile(LveDevice &lveDevice, const std::string &filepath);
+            static std::unique_ptr<LveImage> createImageFromFile(LveDevice &lveDevice, const std::string &filepath,
+                                                                 LveUploadBatch *batch = nullptr);
             VkDescriptorImageInfo descriptorImageInfo();
 
         private:
             void createImage(VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties);
-            void transitionImageLayout(VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
 
             void createImageView(VkFormat format);
             void createTextureSampler();
-            void generateMipmaps();
+            void generateMipmaps(VkCommandBuffer commandBuffer);
 
             LveDevice &lveDevice;
             uint32_t width, height, mipLevels; // Using for MipMaps.
             uint32_t arrayLayers = 1;
             VkImage image;
-            VkDeviceMemory imageMemory;
+            LveMemoryAllocator::Allocation imageMemory{};
             VkImageView imageView;
             VkSampler textureSampler;
         };
@@ -0,0 +1,48 @@
+#include "lve_mapped_file.hpp"
+
+// posix
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// std
+#include <stdexcept>
+
+namespace lve {
+
+    LveMappedFile::LveMappedFile(const std::string &filepath) {
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("failed to stat file: " + filepath);
+        }
+
+        mappedSize = static_cast<size_t>(info.st_size);
+        if (mappedSize > 0) {
+            mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                close(fd);
+                throw std::runtime_error("failed to map file: " + filepath);
+            }
+            // The loaders walk the file front to back exactly once.
+            madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+        }
+
+        // The mapping keeps its own reference to the file.
+        close(fd);
+    }
+
+    LveMappedFile::~LveMappedFile() {
+        if (mapping) {
+            munmap(mapping, mappedSize);
+        }
+    }
+
+}  // namespace lve
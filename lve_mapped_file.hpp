@@ -0,0 +1,31 @@
+#ifndef VULKANTEST_LVE_MAPPED_FILE_HPP
+#define VULKANTEST_LVE_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace lve {
+
+    /**
+     * Read-only memory mapping of a whole file. The mapping lives as long as the object,
+     * so pointers returned by data() must not outlive it.
+     */
+    class LveMappedFile {
+    public:
+        explicit LveMappedFile(const std::string &filepath);
+        ~LveMappedFile();
+
+        LveMappedFile(const LveMappedFile&) = delete;
+        LveMappedFile &operator=(const LveMappedFile&) = delete;
+
+        const char *data() const { return static_cast<const char *>(mapping); }
+        size_t size() const { return mappedSize; }
+
+    private:
+        void *mapping = nullptr;
+        size_t mappedSize = 0;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MAPPED_FILE_HPP
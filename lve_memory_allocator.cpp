@@ -0,0 +1,324 @@
+#include "lve_memory_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    struct LveMemoryAllocator::Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        char *mapped = nullptr;
+        uint32_t memoryType = 0;
+        uint32_t pool = 0;
+        bool dedicated = false;
+        uint32_t maxOrder = 0;  // the whole block is one node of this order
+        std::vector<std::set<VkDeviceSize>> freeNodes;  // offsets of the free nodes, per order
+        uint32_t allocations = 0;
+        VkDeviceSize allocatedBytes = 0;
+    };
+
+    namespace {
+
+        VkDeviceSize nodeSize(uint32_t order) { return LveMemoryAllocator::MIN_ALLOCATION << order; }
+
+        uint32_t orderFor(VkDeviceSize size) {
+            uint32_t order = 0;
+            while (nodeSize(order) < size) order++;
+            return order;
+        }
+
+        void addUsage(LveMemoryAllocator::Usage &usage, uint64_t bytes) {
+            usage.bytes += bytes;
+            usage.peakBytes = std::max(usage.peakBytes, usage.bytes);
+            usage.allocations++;
+        }
+
+        void removeUsage(LveMemoryAllocator::Usage &usage, uint64_t bytes) {
+            usage.bytes -= bytes;
+            usage.allocations--;
+        }
+
+    }  // namespace
+
+    const char *LveMemoryAllocator::categoryName(Category category) {
+        switch (category) {
+            case Category::Mesh: return "mesh";
+            case Category::Texture: return "texture";
+            case Category::Uniform: return "uniform";
+            case Category::Staging: return "staging";
+            case Category::Attachment: return "attachment";
+            default: return "other";
+        }
+    }
+
+    LveMemoryAllocator::Category LveMemoryAllocator::bufferCategory(VkBufferUsageFlags usage) {
+        // Uniforms first: the frame allocator's buffer also allows vertex and index data.
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) return Category::Uniform;
+        if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) return Category::Mesh;
+        if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) return Category::Staging;
+        return Category::Other;
+    }
+
+    LveMemoryAllocator::Category LveMemoryAllocator::imageCategory(VkImageUsageFlags usage) {
+        if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
+            return Category::Attachment;
+        }
+        if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) return Category::Texture;
+        return Category::Other;
+    }
+
+    LveMemoryAllocator::LveMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device,
+                                           const VkAllocationCallbacks *allocationCallbacks,
+                                           PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2,
+                                           VkDeviceSize blockSize)
+            : physicalDevice{physicalDevice}, device{device}, allocationCallbacks{allocationCallbacks},
+              getMemoryProperties2{getMemoryProperties2} {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+        heaps.resize(memoryProperties.memoryHeapCount);
+        for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++) {
+            heaps[heap].size = memoryProperties.memoryHeaps[heap].size;
+            heaps[heap].flags = memoryProperties.memoryHeaps[heap].flags;
+        }
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        separateImages = properties.limits.bufferImageGranularity > MIN_ALLOCATION;
+
+        blockSize = nodeSize(orderFor(std::max(blockSize, MIN_ALLOCATION) + 1) - 1);  // round down to a power of two
+        uint32_t kinds = separateImages ? 2 : 1;
+        pools.resize(memoryProperties.memoryTypeCount * kinds);
+        for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+            VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[type].heapIndex].size;
+            VkDeviceSize size = blockSize;
+            while (heapSize > 0 && size > heapSize / 8 && size > MIN_ALLOCATION) size /= 2;
+            for (uint32_t kind = 0; kind < kinds; kind++) {
+                pools[type * kinds + kind].blockSize = size;
+            }
+        }
+    }
+
+    LveMemoryAllocator::~LveMemoryAllocator() {
+        assert(allocations == 0 && "Device memory still allocated when the allocator is destroyed");
+        for (auto &pool : pools) {
+            for (auto &block : pool.blocks) {
+                if (block->mapped) vkUnmapMemory(device, block->memory);
+                vkFreeMemory(device, block->memory, allocationCallbacks);
+            }
+        }
+    }
+
+    LveMemoryAllocator::Block *LveMemoryAllocator::createBlock(uint32_t memoryType, uint32_t pool,
+                                                               VkDeviceSize size, bool dedicated) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+
+        auto block = std::make_unique<Block>();
+        if (vkAllocateMemory(device, &allocInfo, allocationCallbacks, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+        block->size = size;
+        block->memoryType = memoryType;
+        block->pool = pool;
+        block->dedicated = dedicated;
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            void *mapped = nullptr;
+            if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+                vkFreeMemory(device, block->memory, allocationCallbacks);
+                throw std::runtime_error("failed to map device memory block!");
+            }
+            block->mapped = static_cast<char *>(mapped);
+        }
+        if (!dedicated) {
+            block->maxOrder = orderFor(size);
+            block->freeNodes.resize(block->maxOrder + 1);
+            block->freeNodes[block->maxOrder].insert(0);
+        }
+        addUsage(heaps[memoryProperties.memoryTypes[memoryType].heapIndex].blocks, size);
+
+        pools[pool].blocks.push_back(std::move(block));
+        return pools[pool].blocks.back().get();
+    }
+
+    void LveMemoryAllocator::destroyBlock(Block *block) {
+        auto &blocks = pools[block->pool].blocks;
+        auto it = std::find_if(blocks.begin(), blocks.end(), [block](const auto &b) { return b.get() == block; });
+        removeUsage(heaps[memoryProperties.memoryTypes[block->memoryType].heapIndex].blocks, block->size);
+        if (block->mapped) vkUnmapMemory(device, block->memory);
+        vkFreeMemory(device, block->memory, allocationCallbacks);
+        blocks.erase(it);
+    }
+
+    void LveMemoryAllocator::track(const Allocation &allocation, bool add) {
+        HeapBudget &heap = heaps[memoryProperties.memoryTypes[allocation.memoryType].heapIndex];
+        auto category = static_cast<size_t>(allocation.category);
+        if (add) {
+            addUsage(heap.categories[category], allocation.size);
+            addUsage(categories[category], allocation.size);
+        } else {
+            removeUsage(heap.categories[category], allocation.size);
+            removeUsage(categories[category], allocation.size);
+        }
+    }
+
+    LveMemoryAllocator::Allocation LveMemoryAllocator::allocate(const VkMemoryRequirements &requirements,
+                                                                uint32_t memoryType, Kind kind, Category category) {
+        std::lock_guard<std::mutex> lock{mutex};
+        uint32_t poolIndex = separateImages ? memoryType * 2 + (kind == Kind::Optimal ? 1 : 0) : memoryType;
+        Pool &pool = pools[poolIndex];
+        VkDeviceSize needed = std::max({requirements.size, requirements.alignment, MIN_ALLOCATION});
+
+        Allocation allocation{};
+        allocation.memoryType = memoryType;
+        if (needed > pool.blockSize / 2) {
+            Block *block = createBlock(memoryType, poolIndex, requirements.size, true);
+            block->allocations = 1;
+            block->allocatedBytes = block->size;
+            allocation.memory = block->memory;
+            allocation.size = block->size;
+            allocation.mapped = block->mapped;
+            allocation.block = block;
+        } else {
+            // Best fit over the blocks: the one whose smallest sufficient free node is smallest.
+            uint32_t order = orderFor(needed);
+            Block *best = nullptr;
+            uint32_t bestOrder = 0;
+            for (auto &block : pool.blocks) {
+                if (block->dedicated) continue;
+                for (uint32_t o = order; o <= block->maxOrder && (!best || o < bestOrder); o++) {
+                    if (!block->freeNodes[o].empty()) {
+                        best = block.get();
+                        bestOrder = o;
+                        break;
+                    }
+                }
+                if (best && bestOrder == order) break;
+            }
+            if (!best) {
+                best = createBlock(memoryType, poolIndex, pool.blockSize, false);
+                bestOrder = best->maxOrder;
+            }
+
+            // Split the node down to the requested order, freeing the upper halves.
+            auto node = best->freeNodes[bestOrder].begin();
+            VkDeviceSize offset = *node;
+            best->freeNodes[bestOrder].erase(node);
+            while (bestOrder > order) {
+                bestOrder--;
+                best->freeNodes[bestOrder].insert(offset + nodeSize(bestOrder));
+            }
+            best->allocations++;
+            best->allocatedBytes += nodeSize(order);
+
+            allocation.memory = best->memory;
+            allocation.offset = offset;
+            allocation.size = nodeSize(order);
+            allocation.mapped = best->mapped ? best->mapped + offset : nullptr;
+            allocation.block = best;
+            allocation.order = order;
+        }
+        allocations++;
+        requestedBytes += requirements.size;
+        allocation.requested = requirements.size;
+        allocation.category = category;
+        track(allocation, true);
+        return allocation;
+    }
+
+    void LveMemoryAllocator::free(Allocation &allocation) {
+        if (!allocation) return;
+        std::lock_guard<std::mutex> lock{mutex};
+        Block *block = allocation.block;
+        allocations--;
+        requestedBytes -= allocation.requested;
+        track(allocation, false);
+        block->allocations--;
+        if (block->dedicated) {
+            destroyBlock(block);
+            allocation = {};
+            return;
+        }
+
+        // Merge with the buddy for as long as it is free too.
+        VkDeviceSize offset = allocation.offset;
+        uint32_t order = allocation.order;
+        block->allocatedBytes -= nodeSize(order);
+        while (order < block->maxOrder) {
+            auto buddy = block->freeNodes[order].find(offset ^ nodeSize(order));
+            if (buddy == block->freeNodes[order].end()) break;
+            offset = std::min(offset, *buddy);
+            block->freeNodes[order].erase(buddy);
+            order++;
+        }
+        block->freeNodes[order].insert(offset);
+        allocation = {};
+
+        // Keep one empty block per pool around, so a resource that is recreated every so often
+        // doesn't allocate and free a whole block each time.
+        if (block->allocations == 0) {
+            for (auto &other : pools[block->pool].blocks) {
+                if (other.get() != block && !other->dedicated && other->allocations == 0) {
+                    destroyBlock(block);
+                    break;
+                }
+            }
+        }
+    }
+
+    LveMemoryAllocator::Stats LveMemoryAllocator::getStats() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        Stats stats{};
+        stats.allocations = allocations;
+        stats.requestedBytes = requestedBytes;
+        for (const auto &pool : pools) {
+            for (const auto &block : pool.blocks) {
+                stats.blocks++;
+                stats.blockBytes += block->size;
+                stats.allocatedBytes += block->allocatedBytes;
+                if (block->dedicated) {
+                    stats.dedicatedAllocations++;
+                    continue;
+                }
+                for (uint32_t order = block->maxOrder + 1; order-- > 0;) {
+                    if (!block->freeNodes[order].empty()) {
+                        stats.largestFreeNode = std::max(stats.largestFreeNode, nodeSize(order));
+                        break;
+                    }
+                }
+            }
+        }
+        return stats;
+    }
+
+    LveMemoryAllocator::Budget LveMemoryAllocator::getBudget() const {
+        Budget budget{};
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        if (getMemoryProperties2) {
+            budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+            VkPhysicalDeviceMemoryProperties2KHR properties{};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+            properties.pNext = &budgetProperties;
+            getMemoryProperties2(physicalDevice, &properties);
+            budget.fromExtension = true;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        budget.heaps = heaps;
+        budget.categories = categories;
+        for (uint32_t heap = 0; heap < budget.heaps.size(); heap++) {
+            auto &heapBudget = budget.heaps[heap];
+            if (budget.fromExtension) {
+                heapBudget.budget = budgetProperties.heapBudget[heap];
+                heapBudget.usage = budgetProperties.heapUsage[heap];
+            } else {
+                heapBudget.budget = heapBudget.size / 10 * 8;
+                heapBudget.usage = heapBudget.blocks.bytes;
+            }
+        }
+        return budget;
+    }
+
+}  // namespace lve
@@ -0,0 +1,166 @@
+#ifndef VULKANTEST_LVE_MEMORY_ALLOCATOR_HPP
+#define VULKANTEST_LVE_MEMORY_ALLOCATOR_HPP
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Suballocates device memory for buffers and images from large blocks, so thousands of
+     * resources don't need thousands of vkAllocateMemory calls (the driver limit can be as low
+     * as 4096 allocations).
+     *
+     * Each memory type has its own list of blocks, each block is a buddy allocator: a request is
+     * rounded up to a power of two of at least MIN_ALLOCATION, split off a larger free node, and
+     * merged back with its buddy when freed. Nodes are aligned to their size, which covers every
+     * alignment requirement and nonCoherentAtomSize. Requests over half a block get a dedicated
+     * vkAllocateMemory of their own.
+     *
+     * Linear resources (buffers) and optimal tiled images must not share a
+     * bufferImageGranularity page. When the granularity is larger than MIN_ALLOCATION the two
+     * kinds get separate blocks; otherwise no two nodes can share a page and they are mixed.
+     *
+     * Host visible blocks stay mapped for their lifetime; an allocation's mapped points at its
+     * offset. Thread safe.
+     *
+     * Every allocation is tagged with the Category of the resource it backs. getBudget() reports
+     * live and peak bytes per category and per heap next to the heap budgets, which come from
+     * VK_EXT_memory_budget when the device has it enabled.
+     */
+    class LveMemoryAllocator {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+        static constexpr VkDeviceSize MIN_ALLOCATION = 256;
+
+        enum class Kind { Linear, Optimal };
+
+        // What the memory is used for, for the accounting only.
+        enum class Category { Mesh, Texture, Uniform, Staging, Attachment, Other };
+        static constexpr uint32_t CATEGORY_COUNT = 6;
+        static const char *categoryName(Category category);
+        // Guesses the category from the usage flags LveDevice creates the resource with.
+        static Category bufferCategory(VkBufferUsageFlags usage);
+        static Category imageCategory(VkImageUsageFlags usage);
+
+        struct Block;
+
+        struct Allocation {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;     // reserved bytes, at least the requested size
+            void *mapped = nullptr;    // host visible memory only
+            uint32_t memoryType = 0;
+
+            explicit operator bool() const { return memory != VK_NULL_HANDLE; }
+
+        private:
+            friend class LveMemoryAllocator;
+            Block *block = nullptr;
+            uint32_t order = 0;
+            VkDeviceSize requested = 0;
+            Category category = Category::Other;
+        };
+
+        struct Stats {
+            uint32_t blocks = 0;
+            uint32_t dedicatedAllocations = 0;  // counted in blocks as well
+            uint32_t allocations = 0;
+            uint64_t blockBytes = 0;      // device memory allocated from the driver
+            uint64_t requestedBytes = 0;  // sum of the resources' memory requirements
+            uint64_t allocatedBytes = 0;  // after rounding to buddy nodes
+            uint64_t largestFreeNode = 0;
+            // Share of the block memory holding resources.
+            float utilization() const {
+                return blockBytes == 0 ? 0.0f : static_cast<float>(requestedBytes) / static_cast<float>(blockBytes);
+            }
+            // 0 when all free space is one node, towards 1 the more it is scattered.
+            float fragmentation() const {
+                uint64_t freeBytes = blockBytes - allocatedBytes;
+                return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeNode) / static_cast<float>(freeBytes);
+            }
+        };
+
+        struct Usage {
+            uint64_t bytes = 0;  // reserved by the live allocations, or held in blocks for a heap
+            uint64_t peakBytes = 0;
+            uint32_t allocations = 0;
+        };
+
+        struct HeapBudget {
+            VkDeviceSize size = 0;
+            VkMemoryHeapFlags flags = 0;
+            Usage blocks;  // device memory the allocator holds in this heap
+            std::array<Usage, CATEGORY_COUNT> categories{};
+            // With VK_EXT_memory_budget: what the process can allocate from the heap before
+            // performance suffers, and what it uses including driver internal allocations and
+            // allocations made around the allocator. Otherwise 80% of the heap and blocks.bytes.
+            VkDeviceSize budget = 0;
+            VkDeviceSize usage = 0;
+        };
+
+        struct Budget {
+            bool fromExtension = false;
+            std::vector<HeapBudget> heaps;
+            std::array<Usage, CATEGORY_COUNT> categories{};  // over all heaps
+        };
+
+        // blockSize is rounded down to a power of two, and for small heaps to an eighth of the heap.
+        // getMemoryProperties2 is only passed when VK_EXT_memory_budget is enabled on device.
+        LveMemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device,
+                           const VkAllocationCallbacks *allocationCallbacks = nullptr,
+                           PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr,
+                           VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+        ~LveMemoryAllocator();
+
+        LveMemoryAllocator(const LveMemoryAllocator &) = delete;
+        LveMemoryAllocator &operator=(const LveMemoryAllocator &) = delete;
+
+        // memoryType as found by LveDevice::findMemoryType. Throws when the device is out of memory.
+        Allocation allocate(const VkMemoryRequirements &requirements, uint32_t memoryType, Kind kind,
+                            Category category = Category::Other);
+        // Resets allocation; freeing an empty allocation does nothing.
+        void free(Allocation &allocation);
+
+        Stats getStats() const;
+        // Queries the driver's budgets, so don't call it every frame.
+        Budget getBudget() const;
+        VkMemoryPropertyFlags getMemoryTypeFlags(uint32_t memoryType) const {
+            return memoryProperties.memoryTypes[memoryType].propertyFlags;
+        }
+
+    private:
+        struct Pool {
+            VkDeviceSize blockSize;
+            std::vector<std::unique_ptr<Block>> blocks;
+        };
+
+        Block *createBlock(uint32_t memoryType, uint32_t pool, VkDeviceSize size, bool dedicated);
+        void destroyBlock(Block *block);
+        void track(const Allocation &allocation, bool add);
+
+        VkPhysicalDevice physicalDevice;
+        VkDevice device;
+        const VkAllocationCallbacks *allocationCallbacks;
+        PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        bool separateImages;  // bufferImageGranularity needs blocks per Kind
+        std::vector<Pool> pools;  // per memory type and, with separateImages, per Kind
+
+        mutable std::mutex mutex;
+        uint64_t requestedBytes = 0;
+        uint32_t allocations = 0;
+        std::vector<HeapBudget> heaps;  // the accounting part of getBudget()
+        std::array<Usage, CATEGORY_COUNT> categories{};
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MEMORY_ALLOCATOR_HPP
@@ -0,0 +1,341 @@
+#include "lve_mesh_cache.hpp"
+#include "lve_mapped_file.hpp"
+#include "lve_obj_parser.hpp"
+
+// posix
+#include <unistd.h>
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace lve {
+
+    namespace {
+
+        struct CacheHeader {
+            char magic[4];
+            uint32_t version;
+            uint32_t vertexStride;   // sizeof(LveModel::Vertex) when the file was written
+            uint32_t pathLength;     // bytes of source path stored right after the header
+            uint64_t sourceSize;
+            int64_t sourceMtime;
+            uint64_t vertexCount;
+            uint64_t indexCount;
+            uint64_t vertexOffset;   // byte offsets of the blobs from the start of the file
+            uint64_t indexOffset;
+            uint64_t submeshCount;
+            uint64_t submeshOffset;  // firstIndex, indexCount, material triples
+            uint64_t materialCount;
+            uint64_t materialOffset;  // name and diffuse texture of each, zero terminated
+            uint64_t materialBytes;
+            uint64_t libraryCount;
+            uint64_t libraryOffset;  // size, mtime pairs of each mtllib, then their zero terminated names
+            uint64_t libraryBytes;
+        };
+
+        constexpr char CACHE_MAGIC[4] = {'L', 'V', 'E', 'M'};
+
+        struct SourceInfo {
+            std::string canonicalPath;
+            uint64_t size = 0;
+            int64_t mtime = 0;
+        };
+
+        bool querySource(const std::string &sourcePath, SourceInfo &info) {
+            std::error_code ec;
+            auto canonical = std::filesystem::canonical(sourcePath, ec);
+            if (ec) return false;
+            info.canonicalPath = canonical.string();
+            info.size = std::filesystem::file_size(canonical, ec);
+            if (ec) return false;
+            auto mtime = std::filesystem::last_write_time(canonical, ec);
+            if (ec) return false;
+            info.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+            return true;
+        }
+
+        // Size recorded for an mtllib that did not exist when the cache was written.
+        constexpr uint64_t MISSING_LIBRARY = std::numeric_limits<uint64_t>::max();
+
+        struct LibraryInfo {
+            std::string name;  // as written in the OBJ, relative to its directory
+            uint64_t size = MISSING_LIBRARY;
+            int64_t mtime = 0;
+        };
+
+        void queryLibrary(const std::string &sourcePath, LibraryInfo &library) {
+            // Resolved like parseObj does, against the directory of the path the OBJ was loaded by.
+            auto path = std::filesystem::path(sourcePath).parent_path() / library.name;
+            std::error_code ec;
+            library.size = MISSING_LIBRARY;
+            library.mtime = 0;
+            uint64_t size = std::filesystem::file_size(path, ec);
+            if (ec) return;
+            auto mtime = std::filesystem::last_write_time(path, ec);
+            if (ec) return;
+            library.size = size;
+            library.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+        }
+
+        // Every file named by an mtllib line of the OBJ, in file order and without duplicates.
+        std::vector<LibraryInfo> queryLibraries(const std::string &sourcePath) {
+            LveMappedFile file{sourcePath};
+            const char *p = file.data();
+            const char *end = p + file.size();
+            std::vector<LibraryInfo> libraries;
+            while (p < end) {
+                const char *lineEnd = std::find(p, end, '\n');
+                const char *text = p;
+                while (text < lineEnd && (*text == ' ' || *text == '\t')) text++;
+                if (lineEnd - text > 6 && std::memcmp(text, "mtllib", 6) == 0 &&
+                    (text[6] == ' ' || text[6] == '\t')) {
+                    const char *last = lineEnd;
+                    if (last > text && last[-1] == '\r') last--;
+                    for (const auto &name : LveObjParser::splitMtlLibNames(std::string(text + 7, last))) {
+                        bool known = std::any_of(libraries.begin(), libraries.end(),
+                                                 [&name](const LibraryInfo &library) { return library.name == name; });
+                        if (name.empty() || known) continue;
+                        LibraryInfo library{};
+                        library.name = name;
+                        queryLibrary(sourcePath, library);
+                        libraries.push_back(library);
+                    }
+                }
+                p = lineEnd + 1;
+            }
+            return libraries;
+        }
+
+        uint64_t alignUp(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+    }  // namespace
+
+    std::atomic<uint32_t> LveMeshCache::hits{0};
+    std::atomic<uint32_t> LveMeshCache::misses{0};
+    std::atomic<uint32_t> LveMeshCache::writes{0};
+    std::atomic<uint64_t> LveMeshCache::coldLoadMicros{0};
+    std::atomic<uint64_t> LveMeshCache::warmLoadMicros{0};
+
+    std::string LveMeshCache::cachePathFor(const std::string &sourcePath) {
+        return sourcePath + ".meshcache";
+    }
+
+    bool LveMeshCache::load(
+            const std::string &sourcePath,
+            std::vector<LveModel::Vertex> &vertices,
+            std::vector<uint32_t> &indices,
+            std::vector<LveModel::Submesh> &submeshes,
+            std::vector<LveModel::Material> &materials) {
+        SourceInfo source;
+        std::string cachePath = cachePathFor(sourcePath);
+        if (!querySource(sourcePath, source) || !std::filesystem::exists(cachePath)) {
+            misses++;
+            return false;
+        }
+
+        try {
+            LveMappedFile file{cachePath};
+            const char *data = file.data();
+
+            CacheHeader header{};
+            if (file.size() < sizeof(header)) throw std::runtime_error("truncated header");
+            std::memcpy(&header, data, sizeof(header));
+
+            bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                         header.version == FORMAT_VERSION &&
+                         header.vertexStride == sizeof(LveModel::Vertex) &&
+                         header.sourceSize == source.size &&
+                         header.sourceMtime == source.mtime &&
+                         header.pathLength == source.canonicalPath.size() &&
+                         sizeof(header) + header.pathLength <= file.size() &&
+                         std::memcmp(data + sizeof(header), source.canonicalPath.data(), header.pathLength) == 0 &&
+                         header.vertexOffset + header.vertexCount * sizeof(LveModel::Vertex) <= file.size() &&
+                         header.indexOffset + header.indexCount * sizeof(uint32_t) <= file.size() &&
+                         header.submeshOffset + header.submeshCount * 3 * sizeof(uint32_t) <= file.size() &&
+                         header.materialOffset + header.materialBytes <= file.size() &&
+                         header.libraryCount <= header.libraryBytes / (2 * sizeof(uint64_t)) &&
+                         header.libraryOffset + header.libraryBytes <= file.size();
+            if (valid) {
+                // The materials come from the mtllib files, so those have to be unchanged too.
+                const char *libraryData = data + header.libraryOffset;
+                const char *nameData = libraryData + header.libraryCount * 2 * sizeof(uint64_t);
+                const char *libraryEnd = libraryData + header.libraryBytes;
+                for (uint64_t i = 0; valid && i < header.libraryCount; i++) {
+                    LibraryInfo stored{};
+                    std::memcpy(&stored.size, libraryData + 2 * i * sizeof(uint64_t), sizeof(uint64_t));
+                    std::memcpy(&stored.mtime, libraryData + (2 * i + 1) * sizeof(uint64_t), sizeof(int64_t));
+                    const char *nameEnd = std::find(nameData, libraryEnd, '\0');
+                    if (nameEnd == libraryEnd) throw std::runtime_error("truncated material libraries");
+                    LibraryInfo current{};
+                    current.name.assign(nameData, nameEnd);
+                    nameData = nameEnd + 1;
+                    queryLibrary(sourcePath, current);
+                    valid = current.size == stored.size && current.mtime == stored.mtime;
+                }
+            }
+            if (!valid) {
+                misses++;
+                return false;
+            }
+
+            auto vertexData = reinterpret_cast<const LveModel::Vertex *>(data + header.vertexOffset);
+            auto indexData = reinterpret_cast<const uint32_t *>(data + header.indexOffset);
+            vertices.assign(vertexData, vertexData + header.vertexCount);
+            indices.assign(indexData, indexData + header.indexCount);
+            auto submeshData = reinterpret_cast<const uint32_t *>(data + header.submeshOffset);
+            submeshes.clear();
+            for (uint64_t i = 0; i < header.submeshCount; i++) {
+                submeshes.push_back({submeshData[3 * i], submeshData[3 * i + 1],
+                                     static_cast<int32_t>(submeshData[3 * i + 2])});
+            }
+            const char *materialData = data + header.materialOffset;
+            const char *materialEnd = materialData + header.materialBytes;
+            auto readString = [&materialData, materialEnd]() {
+                const char *end = std::find(materialData, materialEnd, '\0');
+                if (end == materialEnd) throw std::runtime_error("truncated materials");
+                std::string text{materialData, end};
+                materialData = end + 1;
+                return text;
+            };
+            materials.clear();
+            for (uint64_t i = 0; i < header.materialCount; i++) {
+                LveModel::Material material{};
+                material.name = readString();
+                material.diffuseTexture = readString();
+                materials.push_back(material);
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "mesh cache: ignoring " << cachePath << ": " << e.what() << std::endl;
+            misses++;
+            return false;
+        }
+
+        hits++;
+        return true;
+    }
+
+    void LveMeshCache::store(
+            const std::string &sourcePath,
+            const std::vector<LveModel::Vertex> &vertices,
+            const std::vector<uint32_t> &indices,
+            const std::vector<LveModel::Submesh> &submeshes,
+            const std::vector<LveModel::Material> &materials) {
+        SourceInfo source;
+        if (!querySource(sourcePath, source)) return;
+        std::vector<LibraryInfo> libraries;
+        try {
+            libraries = queryLibraries(sourcePath);
+        } catch (const std::exception &e) {
+            std::cerr << "mesh cache: not caching " << sourcePath << ": " << e.what() << std::endl;
+            return;
+        }
+
+        CacheHeader header{};
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.vertexStride = sizeof(LveModel::Vertex);
+        header.pathLength = static_cast<uint32_t>(source.canonicalPath.size());
+        header.sourceSize = source.size;
+        header.sourceMtime = source.mtime;
+        header.vertexCount = vertices.size();
+        header.indexCount = indices.size();
+        header.vertexOffset = alignUp(sizeof(header) + header.pathLength, 16);
+        header.indexOffset = alignUp(header.vertexOffset + vertices.size() * sizeof(LveModel::Vertex), 16);
+        header.submeshCount = submeshes.size();
+        header.submeshOffset = header.indexOffset + indices.size() * sizeof(uint32_t);
+        std::vector<uint32_t> submeshRanges;
+        for (const auto &submesh : submeshes) {
+            submeshRanges.push_back(submesh.firstIndex);
+            submeshRanges.push_back(submesh.indexCount);
+            submeshRanges.push_back(static_cast<uint32_t>(submesh.material));
+        }
+        std::string materialStrings;
+        for (const auto &material : materials) {
+            materialStrings += material.name + '\0' + material.diffuseTexture + '\0';
+        }
+        header.materialCount = materials.size();
+        header.materialOffset = header.submeshOffset + submeshRanges.size() * sizeof(uint32_t);
+        header.materialBytes = materialStrings.size();
+        std::vector<uint64_t> libraryStamps;
+        std::string libraryNames;
+        for (const auto &library : libraries) {
+            libraryStamps.push_back(library.size);
+            libraryStamps.push_back(static_cast<uint64_t>(library.mtime));
+            libraryNames += library.name + '\0';
+        }
+        header.libraryCount = libraries.size();
+        header.libraryOffset = alignUp(header.materialOffset + header.materialBytes, 8);
+        header.libraryBytes = libraryStamps.size() * sizeof(uint64_t) + libraryNames.size();
+
+        // Write to a temporary file and rename it into place so a crash mid-write can never
+        // leave a half written cache that passes validation. The name is unique per process and
+        // thread, so concurrent stores of the same model each rename a complete file of their own.
+        std::string cachePath = cachePathFor(sourcePath);
+        std::string tempPath = cachePath + "." + std::to_string(getpid()) + "." +
+                               std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+        {
+            std::ofstream out{tempPath, std::ios::binary | std::ios::trunc};
+            if (!out) {
+                std::cerr << "mesh cache: cannot write " << tempPath << std::endl;
+                return;
+            }
+
+            const char padding[16] = {};
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(source.canonicalPath.data(), header.pathLength);
+            out.write(padding, static_cast<std::streamsize>(header.vertexOffset - sizeof(header) - header.pathLength));
+            out.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(LveModel::Vertex));
+            out.write(padding, static_cast<std::streamsize>(
+                    header.indexOffset - header.vertexOffset - vertices.size() * sizeof(LveModel::Vertex)));
+            out.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+            out.write(reinterpret_cast<const char *>(submeshRanges.data()), submeshRanges.size() * sizeof(uint32_t));
+            out.write(materialStrings.data(), static_cast<std::streamsize>(materialStrings.size()));
+            out.write(padding, static_cast<std::streamsize>(
+                    header.libraryOffset - header.materialOffset - header.materialBytes));
+            out.write(reinterpret_cast<const char *>(libraryStamps.data()), libraryStamps.size() * sizeof(uint64_t));
+            out.write(libraryNames.data(), static_cast<std::streamsize>(libraryNames.size()));
+            if (!out) {
+                std::cerr << "mesh cache: failed writing " << tempPath << std::endl;
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, cachePath, ec);
+        if (ec) {
+            std::cerr << "mesh cache: cannot replace " << cachePath << ": " << ec.message() << std::endl;
+            std::filesystem::remove(tempPath, ec);
+            return;
+        }
+        writes++;
+    }
+
+    void LveMeshCache::recordLoadTime(bool cacheHit, double milliseconds) {
+        auto micros = static_cast<uint64_t>(milliseconds * 1000.0);
+        if (cacheHit) {
+            warmLoadMicros += micros;
+        } else {
+            coldLoadMicros += micros;
+        }
+    }
+
+    LveMeshCache::Stats LveMeshCache::getStats() {
+        Stats stats{};
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.writes = writes;
+        stats.coldLoadMs = static_cast<double>(coldLoadMicros) / 1000.0;
+        stats.warmLoadMs = static_cast<double>(warmLoadMicros) / 1000.0;
+        return stats;
+    }
+
+}  // namespace lve
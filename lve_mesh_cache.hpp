@@ -0,0 +1,67 @@
+#ifndef VULKANTEST_LVE_MESH_CACHE_HPP
+#define VULKANTEST_LVE_MESH_CACHE_HPP
+
+#include "lve_model.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Binary cache of the vertex/index data LveModel::Builder produces from an OBJ file.
+     *
+     * A cache file lives next to its source ("<source>.meshcache") and is laid out as
+     *   CacheHeader | source path | vertex blob | index blob | submeshes | materials | mtllibs
+     * It is only used when the stored path, modification time and size still match the
+     * source file and the modification time and size of every mtllib it names still match,
+     * so editing or replacing an OBJ or its materials invalidates it automatically.
+     */
+    class LveMeshCache {
+    public:
+        static constexpr uint32_t FORMAT_VERSION = 6;
+
+        struct Stats {
+            uint32_t hits = 0;
+            uint32_t misses = 0;
+            uint32_t writes = 0;
+            double coldLoadMs = 0.0;  // total time of loads that had to parse the OBJ
+            double warmLoadMs = 0.0;  // total time of loads served from the cache
+        };
+
+        static std::string cachePathFor(const std::string &sourcePath);
+
+        // Fills vertices/indices, the level 0 submeshes (without bounds) and the materials from
+        // the cache. Returns false (and counts a miss) if there is
+        // no valid cache entry for the current version of sourcePath.
+        static bool load(
+                const std::string &sourcePath,
+                std::vector<LveModel::Vertex> &vertices,
+                std::vector<uint32_t> &indices,
+                std::vector<LveModel::Submesh> &submeshes,
+                std::vector<LveModel::Material> &materials);
+
+        // Writes the cache entry for sourcePath. Failures only produce a warning, the cache is
+        // an optimization and loading must never depend on it.
+        static void store(
+                const std::string &sourcePath,
+                const std::vector<LveModel::Vertex> &vertices,
+                const std::vector<uint32_t> &indices,
+                const std::vector<LveModel::Submesh> &submeshes,
+                const std::vector<LveModel::Material> &materials);
+
+        static void recordLoadTime(bool cacheHit, double milliseconds);
+        static Stats getStats();
+
+    private:
+        static std::atomic<uint32_t> hits;
+        static std::atomic<uint32_t> misses;
+        static std::atomic<uint32_t> writes;
+        static std::atomic<uint64_t> coldLoadMicros;
+        static std::atomic<uint64_t> warmLoadMicros;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MESH_CACHE_HPP
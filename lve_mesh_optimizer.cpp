@@ -0,0 +1,282 @@
+#include "lve_mesh_optimizer.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace lve {
+
+    namespace {
+
+        constexpr uint32_t NEVER_CACHED = UINT32_MAX;
+
+        // Vertex -> triangle adjacency in compressed row form.
+        struct Adjacency {
+            std::vector<uint32_t> offsets;    // vertexCount + 1 entries
+            std::vector<uint32_t> triangles;  // triangle ids, grouped by vertex
+
+            Adjacency(const uint32_t *indices, size_t indexCount, size_t vertexCount)
+                    : offsets(vertexCount + 1, 0), triangles(indexCount) {
+                for (size_t i = 0; i < indexCount; i++) {
+                    offsets[indices[i] + 1]++;
+                }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indexCount; i++) {
+                    triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+        };
+
+        glm::vec3 triangleCross(const std::vector<LveModel::Vertex> &vertices, const uint32_t *triangle) {
+            const glm::vec3 &a = vertices[triangle[0]].position;
+            const glm::vec3 &b = vertices[triangle[1]].position;
+            const glm::vec3 &c = vertices[triangle[2]].position;
+            return glm::cross(b - a, c - a);  // length is twice the area
+        }
+
+        glm::vec3 triangleCentroid(const std::vector<LveModel::Vertex> &vertices, const uint32_t *triangle) {
+            return (vertices[triangle[0]].position + vertices[triangle[1]].position +
+                    vertices[triangle[2]].position) / 3.0f;
+        }
+
+        // Tipsify from Sander et al. Writes the reordered triangles to `output` and the first
+        // triangle of every hard cluster (a jump to an uncached vertex) to `clusterStarts`.
+        void tipsify(const uint32_t *indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize,
+                     std::vector<uint32_t> &output, std::vector<size_t> &clusterStarts) {
+            Adjacency adjacency{indices, indexCount, vertexCount};
+
+            std::vector<uint32_t> liveTriangles(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++) {
+                liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+            }
+            std::vector<uint32_t> cacheTime(vertexCount, 0);
+            std::vector<bool> emitted(indexCount / 3, false);
+            std::vector<uint32_t> deadEnds;
+            std::vector<uint32_t> candidates;
+
+            output.clear();
+            output.reserve(indexCount);
+            clusterStarts.clear();
+
+            uint32_t timeStamp = cacheSize + 1;
+            size_t scanCursor = 0;
+            auto isCached = [&](uint32_t v) { return timeStamp - cacheTime[v] <= cacheSize; };
+
+            auto skipDeadEnd = [&]() -> int64_t {
+                while (!deadEnds.empty()) {
+                    uint32_t v = deadEnds.back();
+                    deadEnds.pop_back();
+                    if (liveTriangles[v] > 0) return v;
+                }
+                while (scanCursor < vertexCount) {
+                    if (liveTriangles[scanCursor] > 0) return static_cast<int64_t>(scanCursor);
+                    scanCursor++;
+                }
+                return -1;
+            };
+
+            int64_t fanning = skipDeadEnd();
+            while (fanning >= 0) {
+                if (!isCached(static_cast<uint32_t>(fanning))) {
+                    clusterStarts.push_back(output.size() / 3);
+                }
+
+                candidates.clear();
+                auto f = static_cast<uint32_t>(fanning);
+                for (uint32_t a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; a++) {
+                    uint32_t t = adjacency.triangles[a];
+                    if (emitted[t]) continue;
+                    emitted[t] = true;
+                    for (int corner = 0; corner < 3; corner++) {
+                        uint32_t v = indices[3 * t + corner];
+                        output.push_back(v);
+                        deadEnds.push_back(v);
+                        candidates.push_back(v);
+                        liveTriangles[v]--;
+                        if (!isCached(v)) {
+                            cacheTime[v] = timeStamp++;
+                        }
+                    }
+                }
+
+                // Prefer the candidate that stays in the cache longest while all of its
+                // remaining triangles are emitted.
+                int64_t next = -1;
+                uint32_t bestPriority = 0;
+                for (uint32_t v : candidates) {
+                    if (liveTriangles[v] == 0) continue;
+                    uint32_t priority = 0;
+                    if (timeStamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+                        priority = timeStamp - cacheTime[v];
+                    }
+                    if (next < 0 || priority > bestPriority) {
+                        bestPriority = priority;
+                        next = v;
+                    }
+                }
+                fanning = next >= 0 ? next : skipDeadEnd();
+            }
+        }
+
+        // Splits hard clusters wherever a cluster started there would still reach an ACMR of
+        // threshold * the Tipsify result, giving the overdraw sort more freedom.
+        std::vector<size_t> splitClusters(const std::vector<uint32_t> &indices, size_t vertexCount,
+                                          const std::vector<size_t> &hardStarts, float threshold,
+                                          uint32_t cacheSize) {
+            size_t triangleCount = indices.size() / 3;
+            float targetAcmr = threshold * LveMeshOptimizer::analyzeVertexCache(
+                    indices.data(), indices.size(), vertexCount, cacheSize).acmr;
+
+            std::vector<size_t> starts;
+            std::vector<uint32_t> cacheTime(vertexCount, NEVER_CACHED);
+            uint32_t timeStamp = 0;
+            for (size_t c = 0; c < hardStarts.size(); c++) {
+                size_t clusterEnd = c + 1 < hardStarts.size() ? hardStarts[c + 1] : triangleCount;
+                size_t subStart = hardStarts[c];
+                size_t misses = 0;
+                starts.push_back(subStart);
+                timeStamp += cacheSize + 1;  // start every sub cluster with a cold cache
+
+                for (size_t t = subStart; t < clusterEnd; t++) {
+                    for (int corner = 0; corner < 3; corner++) {
+                        uint32_t v = indices[3 * t + corner];
+                        if (cacheTime[v] == NEVER_CACHED || timeStamp - cacheTime[v] > cacheSize) {
+                            cacheTime[v] = timeStamp++;
+                            misses++;
+                        }
+                    }
+                    size_t triangles = t + 1 - subStart;
+                    if (t + 1 < clusterEnd && static_cast<float>(misses) <= targetAcmr * triangles) {
+                        subStart = t + 1;
+                        misses = 0;
+                        starts.push_back(subStart);
+                        timeStamp += cacheSize + 1;
+                    }
+                }
+            }
+            return starts;
+        }
+
+        // Sorts clusters by how far they face away from the mesh centroid. Outward facing
+        // clusters are the likely occluders, so drawing them first rejects more fragments early.
+        void sortClusters(const std::vector<uint32_t> &indices, const std::vector<size_t> &starts,
+                          const std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &output) {
+            size_t triangleCount = indices.size() / 3;
+            glm::vec3 meshCentroid{0.0f};
+            float meshArea = 0.0f;
+            for (size_t t = 0; t < triangleCount; t++) {
+                float area = glm::length(triangleCross(vertices, &indices[3 * t]));
+                meshCentroid += area * triangleCentroid(vertices, &indices[3 * t]);
+                meshArea += area;
+            }
+            if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+            struct Cluster {
+                size_t first;
+                size_t count;
+                float sortKey;
+            };
+            std::vector<Cluster> clusters(starts.size());
+            for (size_t c = 0; c < starts.size(); c++) {
+                size_t end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+                glm::vec3 normal{0.0f};
+                glm::vec3 centroid{0.0f};
+                float area = 0.0f;
+                for (size_t t = starts[c]; t < end; t++) {
+                    glm::vec3 cross = triangleCross(vertices, &indices[3 * t]);
+                    float triangleArea = glm::length(cross);
+                    normal += cross;
+                    centroid += triangleArea * triangleCentroid(vertices, &indices[3 * t]);
+                    area += triangleArea;
+                }
+                float normalLength = glm::length(normal);
+                float key = 0.0f;
+                if (area > 0.0f && normalLength > 0.0f) {
+                    key = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+                }
+                clusters[c] = {starts[c], end - starts[c], key};
+            }
+            std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) {
+                return a.sortKey > b.sortKey;
+            });
+
+            output.clear();
+            output.reserve(indices.size());
+            for (const auto &cluster : clusters) {
+                output.insert(output.end(), indices.begin() + 3 * cluster.first,
+                              indices.begin() + 3 * (cluster.first + cluster.count));
+            }
+        }
+
+    }  // namespace
+
+    LveMeshOptimizer::CacheStats LveMeshOptimizer::analyzeVertexCache(
+            const uint32_t *indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+        CacheStats stats{};
+        if (indexCount < 3 || vertexCount == 0) return stats;
+
+        std::vector<uint32_t> cacheTime(vertexCount, NEVER_CACHED);
+        uint32_t timeStamp = 0;
+        size_t misses = 0;
+        for (size_t i = 0; i < indexCount; i++) {
+            uint32_t v = indices[i];
+            if (cacheTime[v] == NEVER_CACHED || timeStamp - cacheTime[v] > cacheSize) {
+                cacheTime[v] = timeStamp++;
+                misses++;
+            }
+        }
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+        return stats;
+    }
+
+    void LveMeshOptimizer::optimizeVertexCache(
+            uint32_t *indices, size_t indexCount, const std::vector<LveModel::Vertex> &vertices,
+            float overdrawThreshold, uint32_t cacheSize) {
+        if (indexCount < 6) return;
+
+        std::vector<uint32_t> tipsified;
+        std::vector<size_t> hardStarts;
+        tipsify(indices, indexCount, vertices.size(), cacheSize, tipsified, hardStarts);
+
+        // Try progressively coarser clusterings, ending with Tipsify's own clusters, and keep
+        // the plain Tipsify order if sorting would cost more ACMR than the threshold allows.
+        // The tail of every hard cluster can push the total above a split target, hence the
+        // tighter retries.
+        float acmrLimit = overdrawThreshold *
+                analyzeVertexCache(tipsified.data(), tipsified.size(), vertices.size(), cacheSize).acmr;
+        std::vector<std::vector<size_t>> clusterings;
+        for (float slack = overdrawThreshold - 1.0f; slack > 0.01f; slack *= 0.5f) {
+            clusterings.push_back(splitClusters(tipsified, vertices.size(), hardStarts, 1.0f + slack, cacheSize));
+        }
+        clusterings.push_back(hardStarts);
+
+        std::vector<uint32_t> sorted;
+        for (const auto &starts : clusterings) {
+            sortClusters(tipsified, starts, vertices, sorted);
+            if (analyzeVertexCache(sorted.data(), sorted.size(), vertices.size(), cacheSize).acmr <= acmrLimit) {
+                std::copy(sorted.begin(), sorted.end(), indices);
+                return;
+            }
+        }
+        std::copy(tipsified.begin(), tipsified.end(), indices);
+    }
+
+    void LveMeshOptimizer::optimizeVertexFetch(std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices) {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<LveModel::Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (auto &index : indices) {
+            if (remap[index] == UINT32_MAX) {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(reordered);
+    }
+
+}  // namespace lve
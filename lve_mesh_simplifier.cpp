@@ -0,0 +1,315 @@
+#include "lve_mesh_simplifier.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace lve {
+
+    namespace {
+
+        // Symmetric 4x4 quadric stored as its upper triangle, plus the area it was built from.
+        struct Quadric {
+            float a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+            float b0 = 0, b1 = 0, b2 = 0, c = 0;
+            float weight = 0;
+
+            static Quadric fromPlane(const glm::vec3 &normal, float distance, float weight) {
+                Quadric q;
+                q.a00 = weight * normal.x * normal.x;
+                q.a11 = weight * normal.y * normal.y;
+                q.a22 = weight * normal.z * normal.z;
+                q.a10 = weight * normal.y * normal.x;
+                q.a20 = weight * normal.z * normal.x;
+                q.a21 = weight * normal.z * normal.y;
+                q.b0 = weight * normal.x * distance;
+                q.b1 = weight * normal.y * distance;
+                q.b2 = weight * normal.z * distance;
+                q.c = weight * distance * distance;
+                q.weight = weight;
+                return q;
+            }
+
+            Quadric &operator+=(const Quadric &o) {
+                a00 += o.a00; a11 += o.a11; a22 += o.a22;
+                a10 += o.a10; a20 += o.a20; a21 += o.a21;
+                b0 += o.b0; b1 += o.b1; b2 += o.b2;
+                c += o.c;
+                weight += o.weight;
+                return *this;
+            }
+
+            // Area weighted squared distance of p to the planes, normalized back to a distance^2.
+            float error(const glm::vec3 &p) const {
+                float rx = a00 * p.x + a10 * p.y + a20 * p.z + 2 * b0;
+                float ry = a10 * p.x + a11 * p.y + a21 * p.z + 2 * b1;
+                float rz = a20 * p.x + a21 * p.y + a22 * p.z + 2 * b2;
+                float e = rx * p.x + ry * p.y + rz * p.z + c;
+                return weight > 0.0f ? std::abs(e) / weight : 0.0f;
+            }
+        };
+
+        struct Collapse {
+            uint32_t from;  // vertex removed, never on a border or seam
+            uint32_t to;    // vertex it is replaced with
+            float error;
+        };
+
+        // Position -> triangles in compressed row form, rebuilt for every pass.
+        struct TriangleAdjacency {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> triangles;
+
+            void build(const std::vector<uint32_t> &indices, const std::vector<uint32_t> &positionOf,
+                       size_t positionCount) {
+                offsets.assign(positionCount + 1, 0);
+                triangles.resize(indices.size());
+                for (uint32_t index : indices) {
+                    offsets[positionOf[index] + 1]++;
+                }
+                std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+                std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++) {
+                    triangles[fill[positionOf[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+        };
+
+        // Gives every vertex a dense id shared by all vertices at exactly the same position.
+        size_t weldPositions(const std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &positionOf) {
+            std::vector<uint32_t> order(vertices.size());
+            std::iota(order.begin(), order.end(), 0);
+            auto less = [&](uint32_t a, uint32_t b) {
+                const glm::vec3 &pa = vertices[a].position;
+                const glm::vec3 &pb = vertices[b].position;
+                if (pa.x != pb.x) return pa.x < pb.x;
+                if (pa.y != pb.y) return pa.y < pb.y;
+                if (pa.z != pb.z) return pa.z < pb.z;
+                return a < b;
+            };
+            std::sort(order.begin(), order.end(), less);
+
+            positionOf.assign(vertices.size(), 0);
+            size_t positionCount = 0;
+            for (size_t i = 0; i < order.size(); i++) {
+                if (i == 0 || vertices[order[i]].position != vertices[order[i - 1]].position) {
+                    positionCount++;
+                }
+                positionOf[order[i]] = static_cast<uint32_t>(positionCount - 1);
+            }
+            return positionCount;
+        }
+
+    }  // namespace
+
+    float LveMeshSimplifier::getScale(const std::vector<LveModel::Vertex> &vertices) {
+        if (vertices.empty()) return 0.0f;
+        glm::vec3 minimum{vertices[0].position};
+        glm::vec3 maximum{vertices[0].position};
+        for (const auto &vertex : vertices) {
+            minimum = glm::min(minimum, vertex.position);
+            maximum = glm::max(maximum, vertex.position);
+        }
+        glm::vec3 extent = maximum - minimum;
+        return std::max(extent.x, std::max(extent.y, extent.z));
+    }
+
+    std::vector<uint32_t> LveMeshSimplifier::simplify(
+            const std::vector<LveModel::Vertex> &vertices, const std::vector<uint32_t> &indices,
+            size_t targetIndexCount, float targetError, float *resultError) {
+        std::vector<uint32_t> result{indices};
+        float maxError = 0.0f;
+        if (resultError) *resultError = 0.0f;
+        if (vertices.empty() || indices.size() <= targetIndexCount) return result;
+
+        std::vector<uint32_t> positionOf;
+        size_t positionCount = weldPositions(vertices, positionOf);
+
+        // Positions scaled to a unit box so errors are relative to the mesh size.
+        float scale = getScale(vertices);
+        float invScale = scale > 0.0f ? 1.0f / scale : 0.0f;
+        std::vector<glm::vec3> positions(positionCount);
+        for (size_t v = 0; v < vertices.size(); v++) {
+            positions[positionOf[v]] = vertices[v].position * invScale;
+        }
+
+        // Attribute seams: a position referenced through more than one vertex.
+        std::vector<uint8_t> locked(positionCount, 0);
+        {
+            std::vector<uint32_t> seen(positionCount, UINT32_MAX);
+            for (uint32_t index : indices) {
+                uint32_t p = positionOf[index];
+                if (seen[p] == UINT32_MAX) {
+                    seen[p] = index;
+                } else if (seen[p] != index) {
+                    locked[p] = 1;
+                }
+            }
+        }
+
+        // Open borders: a directed edge without its twin.
+        {
+            std::vector<uint64_t> edges;
+            edges.reserve(indices.size());
+            for (size_t i = 0; i < indices.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    uint64_t a = positionOf[indices[i + e]];
+                    uint64_t b = positionOf[indices[i + (e + 1) % 3]];
+                    edges.push_back(a << 32 | b);
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            for (uint64_t edge : edges) {
+                uint64_t twin = (edge << 32) | (edge >> 32);
+                if (!std::binary_search(edges.begin(), edges.end(), twin)) {
+                    locked[edge >> 32] = 1;
+                    locked[edge & 0xffffffffu] = 1;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(positionCount);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            const glm::vec3 &p0 = positions[positionOf[indices[i + 0]]];
+            const glm::vec3 &p1 = positions[positionOf[indices[i + 1]]];
+            const glm::vec3 &p2 = positions[positionOf[indices[i + 2]]];
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(normal);
+            if (length == 0.0f) continue;
+            normal /= length;
+            Quadric q = Quadric::fromPlane(normal, -glm::dot(normal, p0), length * 0.5f);
+            for (int corner = 0; corner < 3; corner++) {
+                quadrics[positionOf[indices[i + corner]]] += q;
+            }
+        }
+
+        float errorLimit = targetError * targetError;
+        TriangleAdjacency adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> collapseTo(vertices.size());
+        std::vector<uint8_t> touched(positionCount);
+        std::vector<uint32_t> ringFrom, ringTo;
+
+        auto gatherRing = [&](uint32_t p, std::vector<uint32_t> &ring) {
+            ring.clear();
+            for (uint32_t a = adjacency.offsets[p]; a < adjacency.offsets[p + 1]; a++) {
+                uint32_t t = adjacency.triangles[a];
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t q = positionOf[result[3 * t + corner]];
+                    if (q != p) ring.push_back(q);
+                }
+            }
+            std::sort(ring.begin(), ring.end());
+            ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+        };
+
+        while (result.size() > targetIndexCount) {
+            adjacency.build(result, positionOf, positionCount);
+
+            // Every interior edge shows up twice, once per direction; evaluate it once.
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; e++) {
+                    uint32_t v0 = result[i + e];
+                    uint32_t v1 = result[i + (e + 1) % 3];
+                    uint32_t p0 = positionOf[v0];
+                    uint32_t p1 = positionOf[v1];
+                    if (p0 >= p1 || (locked[p0] && locked[p1])) continue;
+
+                    Quadric q = quadrics[p0];
+                    q += quadrics[p1];
+                    float error01 = locked[p0] ? INFINITY : q.error(positions[p1]);
+                    float error10 = locked[p1] ? INFINITY : q.error(positions[p0]);
+                    if (error01 <= error10) {
+                        collapses.push_back({v0, v1, error01});
+                    } else {
+                        collapses.push_back({v1, v0, error10});
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(),
+                      [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+            // Each collapse removes about two triangles.
+            size_t collapseBudget = (result.size() - targetIndexCount) / 6 + 1;
+            size_t applied = 0;
+            std::iota(collapseTo.begin(), collapseTo.end(), 0);
+            std::fill(touched.begin(), touched.end(), 0);
+
+            for (const auto &collapse : collapses) {
+                if (collapse.error > errorLimit || applied >= collapseBudget) break;
+                uint32_t from = positionOf[collapse.from];
+                uint32_t to = positionOf[collapse.to];
+                if (touched[from] || touched[to]) continue;
+
+                // Link condition: the two rings may only share the vertices opposite the edge.
+                gatherRing(from, ringFrom);
+                gatherRing(to, ringTo);
+                size_t sharedTriangles = 0;
+                bool flips = false;
+                for (uint32_t a = adjacency.offsets[from]; a < adjacency.offsets[from + 1]; a++) {
+                    const uint32_t *triangle = &result[3 * adjacency.triangles[a]];
+                    glm::vec3 before[3], after[3];
+                    bool containsTo = false;
+                    for (int corner = 0; corner < 3; corner++) {
+                        uint32_t p = positionOf[triangle[corner]];
+                        containsTo |= p == to;
+                        before[corner] = positions[p];
+                        after[corner] = p == from ? positions[to] : positions[p];
+                    }
+                    if (containsTo) {
+                        sharedTriangles++;
+                        continue;
+                    }
+                    glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    if (glm::dot(n0, n1) <= 0.0f) {
+                        flips = true;
+                        break;
+                    }
+                }
+                if (flips) continue;
+                size_t sharedRing = 0;
+                for (size_t a = 0, b = 0; a < ringFrom.size() && b < ringTo.size();) {
+                    if (ringFrom[a] < ringTo[b]) {
+                        a++;
+                    } else if (ringTo[b] < ringFrom[a]) {
+                        b++;
+                    } else {
+                        sharedRing++;
+                        a++;
+                        b++;
+                    }
+                }
+                if (sharedRing != sharedTriangles) continue;
+
+                collapseTo[collapse.from] = collapse.to;
+                quadrics[to] += quadrics[from];
+                touched[from] = 1;
+                touched[to] = 1;
+                for (uint32_t p : ringFrom) touched[p] = 1;
+                maxError = std::max(maxError, collapse.error);
+                applied++;
+            }
+            if (applied == 0) break;
+
+            size_t kept = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                uint32_t a = collapseTo[result[i + 0]];
+                uint32_t b = collapseTo[result[i + 1]];
+                uint32_t c = collapseTo[result[i + 2]];
+                uint32_t pa = positionOf[a], pb = positionOf[b], pc = positionOf[c];
+                if (pa == pb || pb == pc || pc == pa) continue;
+                result[kept++] = a;
+                result[kept++] = b;
+                result[kept++] = c;
+            }
+            result.resize(kept);
+        }
+
+        if (resultError) *resultError = std::sqrt(maxError);
+        return result;
+    }
+
+}  // namespace lve
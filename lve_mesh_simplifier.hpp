@@ -0,0 +1,37 @@
+#ifndef VULKANTEST_LVE_MESH_SIMPLIFIER_HPP
+#define VULKANTEST_LVE_MESH_SIMPLIFIER_HPP
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Quadric error edge collapse simplification, after Garland and Heckbert, "Surface
+     * Simplification Using Quadric Error Metrics" (1997).
+     *
+     * Vertices only ever collapse onto one of their neighbours, so the result indexes the
+     * original vertex array and every LOD can share one vertex buffer. Vertices on open borders
+     * and on attribute seams (one position, several vertices) are never moved, which keeps
+     * silhouettes closed and uv charts intact. Collapses that would flip a triangle or make the
+     * surface non-manifold are rejected.
+     *
+     * Errors are relative to the mesh size (see getScale), so one threshold works for any model.
+     */
+    class LveMeshSimplifier {
+    public:
+        // Simplifies the triangle list towards targetIndexCount, stopping early once the next
+        // collapse would exceed targetError. resultError receives the largest error introduced.
+        static std::vector<uint32_t> simplify(
+                const std::vector<LveModel::Vertex> &vertices, const std::vector<uint32_t> &indices,
+                size_t targetIndexCount, float targetError, float *resultError = nullptr);
+
+        // Factor that converts relative errors to model space distances.
+        static float getScale(const std::vector<LveModel::Vertex> &vertices);
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MESH_SIMPLIFIER_HPP
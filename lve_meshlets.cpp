@@ -0,0 +1,219 @@
+#include "lve_meshlets.hpp"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace lve {
+
+    namespace {
+
+        glm::vec3 triangleNormal(const std::vector<LveModel::Vertex> &vertices, const uint32_t *triangle) {
+            const glm::vec3 &a = vertices[triangle[0]].position;
+            const glm::vec3 &b = vertices[triangle[1]].position;
+            const glm::vec3 &c = vertices[triangle[2]].position;
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float length = glm::length(normal);
+            return length > 0.0f ? normal / length : glm::vec3{0.0f};
+        }
+
+        void computeBounds(const std::vector<LveModel::Vertex> &vertices, const uint32_t *indices,
+                           LveModel::Meshlet &meshlet) {
+            const uint32_t *first = indices + meshlet.firstIndex;
+            glm::vec3 minimum{vertices[first[0]].position};
+            glm::vec3 maximum{minimum};
+            glm::vec3 normalSum{0.0f};
+            for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+                minimum = glm::min(minimum, vertices[first[i]].position);
+                maximum = glm::max(maximum, vertices[first[i]].position);
+            }
+            for (uint32_t i = 0; i < meshlet.indexCount; i += 3) {
+                normalSum += triangleNormal(vertices, first + i);
+            }
+
+            meshlet.center = 0.5f * (minimum + maximum);
+            meshlet.radius = 0.0f;
+            for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+                meshlet.radius = std::max(meshlet.radius, glm::length(vertices[first[i]].position - meshlet.center));
+            }
+
+            // The cone holds every triangle normal; cutoff is the sine of its half angle.
+            meshlet.coneCutoff = 2.0f;
+            float axisLength = glm::length(normalSum);
+            if (axisLength <= 0.0f) return;
+            meshlet.coneAxis = normalSum / axisLength;
+            float minDot = 1.0f;
+            for (uint32_t i = 0; i < meshlet.indexCount; i += 3) {
+                glm::vec3 normal = triangleNormal(vertices, first + i);
+                if (normal != glm::vec3{0.0f}) minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+            }
+            if (minDot > 0.0f) meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+
+    }  // namespace
+
+    std::vector<LveModel::Meshlet> LveMeshlets::build(
+            const std::vector<LveModel::Vertex> &vertices, uint32_t *indices, size_t indexCount,
+            uint32_t maxVertices, uint32_t maxTriangles) {
+        std::vector<LveModel::Meshlet> meshlets;
+        size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0) return meshlets;
+
+        // Vertex -> triangle adjacency in compressed row form.
+        std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+        for (size_t i = 0; i < indexCount; i++) offsets[indices[i] + 1]++;
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        std::vector<uint32_t> adjacency(indexCount);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; i++) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<glm::vec3> normals(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++) {
+            normals[t] = triangleNormal(vertices, &indices[3 * t]);
+        }
+
+        std::vector<uint32_t> output;
+        output.reserve(indexCount);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> meshletOf(vertices.size(), UINT32_MAX);  // last meshlet using the vertex
+        std::vector<uint32_t> candidates;
+        size_t seedCursor = 0;
+
+        while (output.size() < 3 * triangleCount) {
+            auto meshletId = static_cast<uint32_t>(meshlets.size());
+            LveModel::Meshlet meshlet{};
+            meshlet.firstIndex = static_cast<uint32_t>(output.size());
+            uint32_t meshletVertices = 0;
+            uint32_t meshletTriangles = 0;
+            glm::vec3 normalSum{0.0f};
+
+            // Seed next to the previous meshlet so that neighbours end up adjacent in the index
+            // buffer and visible runs merge into few draws.
+            int64_t seed = -1;
+            for (uint32_t t : candidates) {
+                if (!emitted[t]) {
+                    seed = t;
+                    break;
+                }
+            }
+            if (seed < 0) {
+                while (emitted[seedCursor]) seedCursor++;
+                seed = static_cast<int64_t>(seedCursor);
+            }
+            candidates.clear();
+
+            auto newVertices = [&](uint32_t t) {
+                uint32_t count = 0;
+                for (int corner = 0; corner < 3; corner++) count += meshletOf[indices[3 * t + corner]] != meshletId;
+                return count;
+            };
+            auto emit = [&](uint32_t t) {
+                emitted[t] = true;
+                meshletTriangles++;
+                normalSum += normals[t];
+                for (int corner = 0; corner < 3; corner++) {
+                    uint32_t v = indices[3 * t + corner];
+                    output.push_back(v);
+                    if (meshletOf[v] == meshletId) continue;
+                    meshletOf[v] = meshletId;
+                    meshletVertices++;
+                    for (uint32_t a = offsets[v]; a < offsets[v + 1]; a++) {
+                        if (!emitted[adjacency[a]]) candidates.push_back(adjacency[a]);
+                    }
+                }
+            };
+
+            emit(static_cast<uint32_t>(seed));
+
+            while (meshletTriangles < maxTriangles) {
+                // Fewest new vertices first, then the normal closest to the cluster's average.
+                int64_t best = -1;
+                float bestScore = 0.0f;
+                glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3{0.0f};
+                size_t live = 0;
+                for (uint32_t t : candidates) {
+                    if (emitted[t]) continue;
+                    candidates[live++] = t;
+                    uint32_t added = newVertices(t);
+                    if (meshletVertices + added > maxVertices) continue;
+                    float score = static_cast<float>(added) + 0.5f * (1.0f - glm::dot(normals[t], axis));
+                    if (best < 0 || score < bestScore) {
+                        best = t;
+                        bestScore = score;
+                    }
+                }
+                candidates.resize(live);
+                if (best < 0) break;
+                emit(static_cast<uint32_t>(best));
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            }
+
+            meshlet.indexCount = static_cast<uint32_t>(output.size()) - meshlet.firstIndex;
+            meshlets.push_back(meshlet);
+        }
+
+        std::copy(output.begin(), output.end(), indices);  // a trailing partial triangle stays put
+        for (auto &meshlet : meshlets) {
+            computeBounds(vertices, indices, meshlet);
+        }
+        return meshlets;
+    }
+
+    LveMeshlets::CullStats LveMeshlets::cull(
+            const LveModel::Meshlet *meshlets, size_t meshletCount, const glm::mat4 &modelViewProjection,
+            const glm::vec3 &cameraPosition, std::vector<DrawRange> &ranges, bool coneCulling) {
+        // Frustum planes in model space (Gribb-Hartmann, zero to one depth), normalized so the
+        // sphere test works under non-uniform scale.
+        glm::mat4 m = glm::transpose(modelViewProjection);
+        glm::vec4 planes[6] = {m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[2], m[3] - m[2]};
+        for (auto &plane : planes) {
+            float length = glm::length(glm::vec3{plane});
+            if (length > 0.0f) plane /= length;
+        }
+
+        CullStats stats{};
+        size_t firstRange = ranges.size();
+        for (size_t i = 0; i < meshletCount; i++) {
+            const auto &meshlet = meshlets[i];
+            stats.meshletsTested++;
+            stats.trianglesTested += meshlet.indexCount / 3;
+
+            bool visible = true;
+            for (const auto &plane : planes) {
+                if (glm::dot(glm::vec3{plane}, meshlet.center) + plane.w < -meshlet.radius) {
+                    visible = false;
+                    break;
+                }
+            }
+            // Every point of the sphere must see all triangles from behind, see computeBounds.
+            if (visible && coneCulling && meshlet.coneCutoff <= 1.0f) {
+                glm::vec3 toCenter = meshlet.center - cameraPosition;
+                float distance = glm::length(toCenter);
+                if (glm::dot(toCenter, meshlet.coneAxis) >=
+                    meshlet.coneCutoff * distance + meshlet.radius * (1.0f + meshlet.coneCutoff)) {
+                    visible = false;
+                }
+            }
+
+            if (!visible) {
+                stats.meshletsCulled++;
+                stats.trianglesCulled += meshlet.indexCount / 3;
+                continue;
+            }
+            if (ranges.size() > firstRange &&
+                ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex) {
+                ranges.back().indexCount += meshlet.indexCount;
+            } else {
+                ranges.push_back({meshlet.firstIndex, meshlet.indexCount});
+            }
+        }
+        return stats;
+    }
+
+}  // namespace lve
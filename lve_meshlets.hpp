@@ -0,0 +1,55 @@
+#ifndef VULKANTEST_LVE_MESHLETS_HPP
+#define VULKANTEST_LVE_MESHLETS_HPP
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Splits a triangle list into small clusters (meshlets) with a bounding sphere and a normal
+     * cone each, and culls them on the CPU.
+     *
+     * Meshlets are grown greedily over shared vertices, preferring triangles that add no new
+     * vertex and face the same way as the cluster so far, which keeps the normal cones narrow.
+     * The triangles are reordered in place so that every meshlet is one contiguous index range.
+     *
+     * Cone culling assumes a closed mesh seen from outside: a cluster that faces away from the
+     * camera is then hidden by the front of the mesh, even with back face culling disabled.
+     */
+    class LveMeshlets {
+    public:
+        static constexpr uint32_t MAX_VERTICES = 64;
+        static constexpr uint32_t MAX_TRIANGLES = 124;
+
+        struct DrawRange {
+            uint32_t firstIndex;
+            uint32_t indexCount;
+        };
+
+        struct CullStats {
+            uint32_t meshletsTested = 0;
+            uint32_t meshletsCulled = 0;
+            uint64_t trianglesTested = 0;
+            uint64_t trianglesCulled = 0;
+        };
+
+        // Reorders indices[0, indexCount) into meshlets; firstIndex is relative to `indices`.
+        static std::vector<LveModel::Meshlet> build(
+                const std::vector<LveModel::Vertex> &vertices, uint32_t *indices, size_t indexCount,
+                uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+
+        // Appends the index ranges of the meshlets that are inside the frustum and not facing
+        // away from the camera, merging neighbours. modelViewProjection maps model space to clip
+        // space, cameraPosition is in model space. Cull one submesh's meshlets at a time, or
+        // neighbours of different materials get merged.
+        static CullStats cull(const LveModel::Meshlet *meshlets, size_t meshletCount,
+                              const glm::mat4 &modelViewProjection, const glm::vec3 &cameraPosition,
+                              std::vector<DrawRange> &ranges, bool coneCulling = true);
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MESHLETS_HPP
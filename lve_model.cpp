@@ -2,115 +2,339 @@
 // Created by cdgira on 7/10/2023.
 //
 #include "lve_model.hpp"
-#include "lve_utils.hpp"
+#include "lve_mesh_cache.hpp"
+#include "lve_mesh_optimizer.hpp"
+#include "lve_mesh_simplifier.hpp"
+#include "lve_meshlets.hpp"
+#include "lve_obj_parser.hpp"
+#include "lve_streaming_loader.hpp"
+#include "lve_vertex_dedup.hpp"
+#include "lve_vertex_welder.hpp"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
 
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <cstring>
-#include <unordered_map>
+#include <filesystem>
+#include <iostream>
+
+namespace lve {
 
-namespace std {
-    template<> struct hash<lve::LveModel::Vertex> {
-        size_t operator()(lve::LveModel::Vertex const& vertex) const {
-            size_t seed = 0;
-            lve::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-            return seed;
+    namespace {
+
+        // Maps a unit vector onto the [-1, 1] square, folding the lower hemisphere over the diagonals.
+        glm::vec2 octahedralEncode(glm::vec3 n) {
+            float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+            if (l1 == 0.0f) return glm::vec2{0.0f};
+            n /= l1;
+            glm::vec2 e{n.x, n.y};
+            if (n.z < 0.0f) {
+                e = glm::vec2{(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                              (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f)};
+            }
+            return e;
         }
-    };
-}
 
-namespace lve {
+        // Quantizes positions to the mesh bounds; the returned matrix maps [0, 1] back to them.
+        glm::mat4 packVertices(const std::vector<LveModel::Vertex> &vertices,
+                               std::vector<LveModel::PackedVertex> &packed) {
+            glm::vec3 minimum{vertices[0].position};
+            glm::vec3 maximum{vertices[0].position};
+            for (const auto &vertex : vertices) {
+                minimum = glm::min(minimum, vertex.position);
+                maximum = glm::max(maximum, vertex.position);
+            }
+            glm::vec3 extent = maximum - minimum;
+            for (int axis = 0; axis < 3; axis++) {
+                if (extent[axis] <= 0.0f) extent[axis] = 1.0f;  // flat along this axis
+            }
+
+            packed.resize(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                const auto &vertex = vertices[i];
+                auto &out = packed[i];
+                glm::vec3 unit = (vertex.position - minimum) / extent;
+                for (int axis = 0; axis < 3; axis++) {
+                    out.position[axis] = glm::packUnorm1x16(unit[axis]);
+                }
+                out.position[3] = 0;
+
+                uint32_t color = glm::packUnorm4x8(glm::vec4{vertex.color, 1.0f});
+                std::memcpy(out.color, &color, sizeof(out.color));
+
+                glm::vec2 normal = octahedralEncode(vertex.normal);
+                out.normal[0] = static_cast<int16_t>(glm::packSnorm1x16(normal.x));
+                out.normal[1] = static_cast<int16_t>(glm::packSnorm1x16(normal.y));
+
+                out.uv[0] = glm::packHalf1x16(vertex.uv.x);
+                out.uv[1] = glm::packHalf1x16(vertex.uv.y);
+            }
+
+            glm::mat4 dequantization{1.0f};
+            dequantization[0][0] = extent.x;
+            dequantization[1][1] = extent.y;
+            dequantization[2][2] = extent.z;
+            dequantization[3] = glm::vec4{minimum, 1.0f};
+            return dequantization;
+        }
 
-    LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder) : lveDevice(device) {
-        createVertexBuffers(builder.vertices);
-        createIndexBuffers(builder.indices);
+    }  // namespace
+
+    LveModel::LveModel(LveDevice &device, const LveModel::Builder &builder, LveGeometryPool *pool,
+                       LveUploadBatch *batch) : lveDevice(device) {
+        if (pool != nullptr && !allocateFromPool(*pool, builder)) {
+            std::cerr << "Geometry pool is full, model uses its own buffers" << std::endl;
+        }
+        LveUploadBatch ownBatch{lveDevice};
+        LveUploadBatch &upload = batch ? *batch : ownBatch;
+        createVertexBuffers(builder.vertices, builder.options.vertexFormat, upload);
+        createIndexBuffers(builder.indices, upload);
+        ownBatch.flush();  // both copies in one submission
+
+        lods = builder.lods;
+        meshlets = builder.meshlets;
+        if (lods.empty()) {
+            lods.push_back({0, hasIndexBuffer ? indexCount : vertexCount, 0.0f});
+        }
+
+        bounds = builder.bounds;
+        submeshes = builder.submeshes;
+        materials = builder.materials;
+        if (submeshes.empty()) {
+            // Builders filled by hand, like the streamer's proxy cube, never ran loadModel.
+            bounds = LveBounds::compute(reinterpret_cast<const glm::vec3 *>(builder.vertices.data()),
+                                        builder.vertices.size(), sizeof(Vertex));
+            if (hasIndexBuffer) submeshes.push_back({0, indexCount, -1, bounds});
+        }
+    }
+
+    LveModel::LveModel(LveDevice &device, GpuMesh &&mesh) : lveDevice(device) {
+        vertexBuffer = std::move(mesh.vertexBuffer);
+        vertexCount = mesh.vertexCount;
+        vertexBufferSize = sizeof(Vertex) * static_cast<VkDeviceSize>(vertexCount);
+
+        indexBuffer = std::move(mesh.indexBuffer);
+        indexCount = mesh.indexCount;
+        hasIndexBuffer = indexCount > 0;
+        indexType = mesh.indexType;
+        indexBufferSize = (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)) *
+                          static_cast<VkDeviceSize>(indexCount);
+
+        lods.push_back({0, hasIndexBuffer ? indexCount : vertexCount, 0.0f});
+        bounds = mesh.bounds;
+        submeshes.push_back({0, indexCount, -1, bounds});
+    }
+
+    LveModel::~LveModel() {
+        if (geometryPool != nullptr) geometryPool->free(poolAllocation);
     }
 
-    LveModel::~LveModel() { }
+    bool LveModel::allocateFromPool(LveGeometryPool &pool, const Builder &builder) {
+        // Non indexed models keep their own buffer, pool draws always go through the index buffer.
+        if (builder.indices.empty()) return true;
+        VkDeviceSize vertexSize = builder.options.vertexFormat == VertexFormat::Packed ? sizeof(PackedVertex)
+                                                                                        : sizeof(Vertex);
+        VkDeviceSize indexSize = builder.vertices.size() <= UINT16_MAX + 1u ? sizeof(uint16_t) : sizeof(uint32_t);
+        // Defragmenting the pool moves the geometry; draws recorded afterwards use the new offsets.
+        auto relocate = [this, vertexSize, indexSize](const LveGeometryPool::Allocation &allocation) {
+            poolAllocation = allocation;
+            baseVertex = static_cast<int32_t>(allocation.vertexOffset / vertexSize);
+            baseIndex = static_cast<uint32_t>(allocation.indexOffset / indexSize);
+        };
+        if (!pool.allocate(vertexSize * builder.vertices.size(), vertexSize,
+                           indexSize * builder.indices.size(), indexSize, poolAllocation, relocate)) {
+            return false;
+        }
+        geometryPool = &pool;
+        relocate(poolAllocation);
+        return true;
+    }
 
     std::unique_ptr<LveModel> LveModel::createModelFromFile(LveDevice &device, const std::string &filepath) {
+        return createModelFromFile(device, filepath, LoadOptions{});
+    }
+
+    std::unique_ptr<LveModel> LveModel::createModelFromFile(
+            LveDevice &device, const std::string &filepath, const LoadOptions &options, LveGeometryPool *pool) {
+        if (options.streamingBuild) {
+            LveStreamingLoader loader{device, {options.streamingMemoryCap}};
+            auto model = std::make_unique<LveModel>(device, loader.load(filepath));
+            const auto &stats = loader.getStats();
+            constexpr double MiB = 1024.0 * 1024.0;
+            std::cout << "Streamed " << filepath << ": " << stats.vertices << " vertices, " << stats.triangles
+                      << " triangles in " << stats.totalMs << " ms (attributes " << stats.attributePassMs
+                      << " ms, indices " << stats.indexPassMs << " ms, " << stats.stagingFlushes
+                      << " staging flushes); peak " << stats.peakBytes / MiB << " MiB (cap "
+                      << options.streamingMemoryCap / MiB << " MiB) vs >= " << stats.inMemoryPeakBytes / MiB
+                      << " MiB in memory, process peak RSS " << stats.processPeakRssBytes / MiB << " MiB"
+                      << std::endl;
+            return model;
+        }
+
         Builder builder{};
+        builder.options = options;
         builder.loadModel(filepath);
-        return std::make_unique<LveModel>(device, builder);
+        return createModelFromBuilder(device, filepath, builder, pool);
+    }
+
+    std::unique_ptr<LveModel> LveModel::createModelFromBuilder(
+            LveDevice &device, const std::string &filepath, const Builder &builder, LveGeometryPool *pool,
+            LveUploadBatch *batch) {
+        const auto &options = builder.options;
+        const auto &stats = builder.stats;
+        std::cout << "Loaded " << filepath << ": " << builder.vertices.size() << " vertices, "
+                  << builder.indices.size() / 3 << " triangles in " << stats.totalMs << " ms";
+        if (stats.cacheHit) {
+            std::cout << " (mesh cache)";
+        } else {
+            std::cout << " (parse " << stats.parseMs << " ms on " << stats.parseThreads << " threads, "
+                      << (stats.sourceBytes / (1024.0 * 1024.0)) / (stats.parseMs / 1000.0) << " MB/s; dedup "
+                      << stats.dedupMs << " ms)";
+        }
+        if (options.weldVertices) {
+            std::cout << "; welded " << stats.verticesBeforeWeld << " -> " << stats.verticesAfterWeld
+                      << " vertices (" << stats.weldMs << " ms)";
+        }
+        if (options.optimizeVertexCache) {
+            std::cout << "; ACMR " << stats.acmrBefore << " -> " << stats.acmrAfter << ", ATVR "
+                      << stats.atvrBefore << " -> " << stats.atvrAfter << " (" << stats.optimizeMs << " ms)";
+        }
+        if (builder.lods.size() > 1) {
+            std::cout << "; LOD triangles";
+            for (const auto &lod : builder.lods) {
+                std::cout << " " << lod.indexCount / 3;
+            }
+            std::cout << " (" << stats.lodMs << " ms)";
+        }
+        if (!builder.meshlets.empty()) {
+            std::cout << "; " << builder.meshlets.size() << " meshlets (" << stats.meshletMs << " ms)";
+        }
+        std::cout << "; bounds of " << builder.submeshes.size() << " submeshes " << stats.boundsMs << " ms";
+        std::cout << std::endl;
+
+        auto model = std::make_unique<LveModel>(device, builder, pool, batch);
+        if (options.vertexFormat != VertexFormat::Full) {
+            // What the same mesh costs as fp32 vertices and 32 bit indices.
+            VkDeviceSize fullVertexBytes = sizeof(Vertex) * builder.vertices.size();
+            VkDeviceSize fullIndexBytes = sizeof(uint32_t) * builder.indices.size();
+            VkDeviceSize fullBytes = fullVertexBytes + fullIndexBytes;
+            VkDeviceSize packedBytes = model->getVertexBufferSize() + model->getIndexBufferSize();
+            std::cout << "  packed " << filepath << ": " << packedBytes / 1024 << " KiB instead of "
+                      << fullBytes / 1024 << " KiB (" << 100.0 * (1.0 - double(packedBytes) / double(fullBytes))
+                      << "% saved), vertex fetch " << sizeof(PackedVertex) << " instead of " << sizeof(Vertex)
+                      << " bytes, " << (model->getIndexType() == VK_INDEX_TYPE_UINT16 ? 16 : 32)
+                      << " bit indices" << std::endl;
+        }
+        return model;
     }
 
-    void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
+    void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices, VertexFormat format,
+                                       LveUploadBatch &batch) {
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof(vertices[0]);
-
-        LveBuffer stagingBuffer{
-            lveDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)vertices.data());
-
-        vertexBuffer = std::make_unique<LveBuffer>(
-            lveDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-        );
-
+        vertexFormat = format;
+
+        if (format == VertexFormat::Packed) {
+            std::vector<PackedVertex> packed;
+            positionDequantization = packVertices(vertices, packed);
+            uploadVertexData(packed.data(), sizeof(PackedVertex), batch);
+        } else {
+            positionDequantization = glm::mat4{1.f};
+            uploadVertexData(vertices.data(), sizeof(Vertex), batch);
+        }
+    }
 
-        lveDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+    void LveModel::uploadVertexData(const void *data, uint32_t vertexSize, LveUploadBatch &batch) {
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexSize) * vertexCount;
+        vertexBufferSize = bufferSize;
+
+        if (geometryPool != nullptr) {
+            batch.uploadBuffer(geometryPool->getVertexStorage(), data, bufferSize, poolAllocation.vertexOffset);
+        } else {
+            vertexBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                vertexSize,
+                vertexCount,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+            batch.uploadBuffer(*vertexBuffer, data, bufferSize);
+        }
     }
 
-    void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices) {
+    void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices, LveUploadBatch &batch) {
         indexCount = static_cast<uint32_t>(indices.size());
         hasIndexBuffer = indexCount > 0;
         if (!hasIndexBuffer) return;
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        LveBuffer stagingBuffer{
-            lveDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();
-        stagingBuffer.writeToBuffer((void *)indices.data());
-
-        indexBuffer = std::make_unique<LveBuffer>(
-            lveDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        lveDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+        // 16 bit indices halve the index buffer whenever every vertex is addressable with them.
+        std::vector<uint16_t> shortIndices;
+        const void *indexData = indices.data();
+        uint32_t indexSize = sizeof(uint32_t);
+        indexType = VK_INDEX_TYPE_UINT32;
+        if (vertexCount <= UINT16_MAX + 1u) {
+            shortIndices.assign(indices.begin(), indices.end());
+            indexData = shortIndices.data();
+            indexSize = sizeof(uint16_t);
+            indexType = VK_INDEX_TYPE_UINT16;
+        }
+        VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * indexCount;
+        indexBufferSize = bufferSize;
+
+        if (geometryPool != nullptr) {
+            batch.uploadBuffer(geometryPool->getIndexStorage(), indexData, bufferSize, poolAllocation.indexOffset);
+        } else {
+            indexBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                indexSize,
+                indexCount,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            batch.uploadBuffer(*indexBuffer, indexData, bufferSize);
+        }
     }
 
     void LveModel::bind(VkCommandBuffer commandBuffer) {
+        if (geometryPool != nullptr) {
+            geometryPool->bind(commandBuffer, indexType);
+            return;
+        }
         VkBuffer buffers[] = {vertexBuffer->getBuffer()};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
         if (hasIndexBuffer)
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, indexType);
     }
 
     void LveModel::draw(VkCommandBuffer commandBuffer) {
+        draw(commandBuffer, 0);
+    }
+
+    void LveModel::draw(VkCommandBuffer commandBuffer, uint32_t lod) {
+        const Lod &level = lods[std::min(lod, getLodCount() - 1)];
         if (hasIndexBuffer)
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            vkCmdDrawIndexed(commandBuffer, level.indexCount, 1, baseIndex + level.firstIndex, baseVertex, 0);
         else
             vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
     }
 
+    LveModel::Lod LveModel::getSubmeshRange(const Submesh &submesh, uint32_t lod) const {
+        lod = std::min(lod, getLodCount() - 1);
+        if (lod == 0 || submesh.lods.empty()) return {submesh.firstIndex, submesh.indexCount, 0.0f};
+        return submesh.lods[std::min<size_t>(lod - 1, submesh.lods.size() - 1)];
+    }
+
+    void LveModel::drawRange(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount) {
+        assert(hasIndexBuffer && "Index ranges need an index buffer");
+        vkCmdDrawIndexed(commandBuffer, indexCount, 1, baseIndex + firstIndex, baseVertex, 0);
+    }
+
     std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescriptions() {
         std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
         bindingDescriptions[0].binding = 0;
@@ -130,22 +354,133 @@ namespace lve {
         return attributeDescriptions;
     }
 
+    std::vector<VkVertexInputBindingDescription> LveModel::PackedVertex::getBindingDescriptions() {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> LveModel::PackedVertex::getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        attributeDescriptions.push_back({0,0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position)});
+        attributeDescriptions.push_back({1,0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color)});
+        attributeDescriptions.push_back({2,0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal)});
+        attributeDescriptions.push_back({3,0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv)});
+
+        return attributeDescriptions;
+    }
+
     void LveModel::Builder::loadModel(const std::string &filepath) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        auto elapsedMs = [&startTime]() {
+            return std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - startTime).count();
+        };
+
+        stats = {};
+        stats.cacheHit = options.useMeshCache && LveMeshCache::load(filepath, vertices, indices, submeshes, materials);
+        if (!stats.cacheHit) {
+            parseObj(filepath);
+            if (options.useMeshCache) {
+                LveMeshCache::store(filepath, vertices, indices, submeshes, materials);
+            }
+        }
+
+        // The cache holds the plain parse result, so these passes also run after a cache hit.
+        if (options.weldVertices) {
+            weld();
+        }
+        buildLods();
+        buildMeshlets();
+        if (options.optimizeVertexCache) {
+            optimize();
+        }
+        computeBounds();
+
+        stats.totalMs = elapsedMs();
+        if (options.useMeshCache) {
+            LveMeshCache::recordLoadTime(stats.cacheHit, stats.totalMs);
+        }
+    }
+
+    void LveModel::Builder::parseObj(const std::string &filepath) {
+        auto parseStart = std::chrono::high_resolution_clock::now();
         tinyobj::attrib_t attrib;
         std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
-
-        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
-            throw std::runtime_error(warn + err);
+        std::vector<tinyobj::material_t> objMaterials;
+        // mtllib names are relative to the OBJ, not to the working directory.
+        std::string mtlBaseDir = std::filesystem::path(filepath).parent_path().string();
+
+        if (options.parallelParse) {
+            LveObjParser parser{options.parseThreads,
+                                options.memoryMapSource ? LveObjParser::ReadMode::MemoryMap
+                                                        : LveObjParser::ReadMode::Stream};
+            parser.parse(filepath, mtlBaseDir);
+            attrib = std::move(parser.attrib);
+            shapes = std::move(parser.shapes);
+            objMaterials = std::move(parser.materials);
+            stats.parseThreads = parser.stats.threads;
+            stats.sourceBytes = parser.stats.bytes;
+        } else {
+            std::string warn, err;
+            if (!tinyobj::LoadObj(&attrib, &shapes, &objMaterials, &warn, &err, filepath.c_str(),
+                                  mtlBaseDir.c_str())) {
+                throw std::runtime_error(warn + err);
+            }
+            stats.parseThreads = 1;
+            stats.sourceBytes = std::filesystem::file_size(filepath);
         }
 
+        auto dedupStart = std::chrono::high_resolution_clock::now();
+        stats.parseMs = std::chrono::duration<double, std::milli>(dedupStart - parseStart).count();
+
         vertices.clear();
         indices.clear();
+        submeshes.clear();
+        materials.clear();
+        for (const auto &material : objMaterials) {
+            materials.push_back({material.name, material.diffuse_texname});
+        }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-        for (const auto &shape : shapes) {
-            for (const auto &index: shape.mesh.indices) {
+        // Split every shape by material, then order the parts by material so that submeshes
+        // drawn with the same texture follow each other.
+        struct Part {
+            int material;
+            size_t shape;
+            std::vector<uint32_t> triangles;
+        };
+        std::vector<Part> parts;
+        size_t indexCount = 0;
+        for (size_t shape = 0; shape < shapes.size(); shape++) {
+            const auto &mesh = shapes[shape].mesh;
+            size_t firstPart = parts.size();
+            for (uint32_t triangle = 0; triangle < mesh.indices.size() / 3; triangle++) {
+                int material = triangle < mesh.material_ids.size() ? mesh.material_ids[triangle] : -1;
+                if (material >= static_cast<int>(materials.size())) material = -1;
+                auto part = std::find_if(parts.begin() + firstPart, parts.end(),
+                                         [material](const Part &part) { return part.material == material; });
+                if (part == parts.end()) {
+                    parts.push_back({material, shape, {}});
+                    part = parts.end() - 1;
+                }
+                part->triangles.push_back(triangle);
+            }
+            indexCount += mesh.indices.size();
+        }
+        std::stable_sort(parts.begin(), parts.end(),
+                         [](const Part &a, const Part &b) { return a.material < b.material; });
+        indices.reserve(indexCount);
+
+        LveVertexDedup uniqueVertices{vertices, indexCount};
+        for (const auto &part : parts) {
+            submeshes.push_back({static_cast<uint32_t>(indices.size()),
+                                 static_cast<uint32_t>(part.triangles.size() * 3), part.material});
+            const auto &shapeIndices = shapes[part.shape].mesh.indices;
+            for (uint32_t corner = 0; corner < part.triangles.size() * 3; corner++) {
+                const auto &index = shapeIndices[3 * part.triangles[corner / 3] + corner % 3];
                 Vertex vertex{};
 
                 if (index.vertex_index >= 0) {
@@ -177,13 +512,188 @@ namespace lve {
                     };
                 }
 
-                if (uniqueVertices.count(vertex) == 0) {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
+                indices.push_back(uniqueVertices.findOrInsert(vertex));
+            }
+        }
+
+        stats.dedupMs = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - dedupStart).count();
+    }
+
+    void LveModel::Builder::weld() {
+        LveVertexWelder::Settings settings{};
+        settings.positionEpsilon = options.weldPositionEpsilon * LveMeshSimplifier::getScale(vertices);
+        settings.normalEpsilon = options.weldNormalEpsilon;
+        settings.uvEpsilon = options.weldUvEpsilon;
+        settings.threadCount = options.parseThreads;
+        auto weldStats = LveVertexWelder::weld(vertices, indices, settings);
+
+        // Drop the triangles that collapsed, closing the gaps between the submeshes.
+        uint32_t written = 0;
+        std::vector<Submesh> kept;
+        for (auto &submesh : submeshes) {
+            uint32_t firstIndex = written;
+            for (uint32_t i = submesh.firstIndex; i + 2 < submesh.firstIndex + submesh.indexCount; i += 3) {
+                uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+                if (a == b || b == c || c == a) continue;
+                indices[written++] = a;
+                indices[written++] = b;
+                indices[written++] = c;
+            }
+            if (written == firstIndex) continue;
+            submesh.firstIndex = firstIndex;
+            submesh.indexCount = written - firstIndex;
+            kept.push_back(std::move(submesh));
+        }
+        indices.resize(written);
+        submeshes = std::move(kept);
+
+        stats.weldMs = weldStats.ms;
+        stats.verticesBeforeWeld = weldStats.verticesBefore;
+        stats.verticesAfterWeld = weldStats.verticesAfter;
+    }
+
+    void LveModel::Builder::buildLods() {
+        lods.clear();
+        if (options.lodCount <= 1 || indices.empty()) return;
+        auto lodStart = std::chrono::high_resolution_clock::now();
+
+        // Each level is simplified from the previous one and appended to the same index list.
+        // Submeshes are simplified separately, so no triangle changes its material and every
+        // level holds the submeshes in the same order as level 0.
+        float scale = LveMeshSimplifier::getScale(vertices);
+        lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+        std::vector<std::vector<uint32_t>> sources;
+        for (auto &submesh : submeshes) {
+            submesh.lods.clear();
+            sources.emplace_back(indices.begin() + submesh.firstIndex,
+                                 indices.begin() + submesh.firstIndex + submesh.indexCount);
+        }
+        float error = 0.0f;
+        std::vector<std::vector<uint32_t>> simplified(submeshes.size());
+        while (lods.size() < options.lodCount) {
+            size_t sourceCount = 0, simplifiedCount = 0;
+            float levelError = 0.0f;
+            for (size_t i = 0; i < sources.size(); i++) {
+                size_t target = static_cast<size_t>(sources[i].size() / 3 * options.lodReduction) * 3;
+                float submeshError = 0.0f;
+                simplified[i] = LveMeshSimplifier::simplify(vertices, sources[i], target, options.lodMaxError,
+                                                            &submeshError);
+                // A submesh that cannot lose triangles within the error limit stays as it is.
+                if (simplified[i].empty()) simplified[i] = sources[i];
+                sourceCount += sources[i].size();
+                simplifiedCount += simplified[i].size();
+                levelError = std::max(levelError, submeshError);
+            }
+            if (simplifiedCount * 10 > sourceCount * 9) break;  // less than 10% gained
+
+            error += levelError * scale;  // errors of consecutive levels add up at worst
+            lods.push_back({static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplifiedCount), error});
+            for (size_t i = 0; i < sources.size(); i++) {
+                submeshes[i].lods.push_back({static_cast<uint32_t>(indices.size()),
+                                             static_cast<uint32_t>(simplified[i].size()), error});
+                indices.insert(indices.end(), simplified[i].begin(), simplified[i].end());
+                sources[i] = std::move(simplified[i]);
+            }
+        }
+        stats.lodMs = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - lodStart).count();
+    }
+
+    void LveModel::Builder::buildMeshlets() {
+        meshlets.clear();
+        if (!options.buildMeshlets || indices.empty()) return;
+        auto meshletStart = std::chrono::high_resolution_clock::now();
+
+        // Per submesh, so that reordering the triangles into meshlets keeps the submesh ranges.
+        for (auto &submesh : submeshes) {
+            auto submeshMeshlets = LveMeshlets::build(vertices, indices.data() + submesh.firstIndex, submesh.indexCount);
+            submesh.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+            submesh.meshletCount = static_cast<uint32_t>(submeshMeshlets.size());
+            for (auto &meshlet : submeshMeshlets) {
+                meshlet.firstIndex += submesh.firstIndex;
+                meshlets.push_back(meshlet);
+            }
+        }
+
+        stats.meshletMs = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - meshletStart).count();
+    }
+
+    void LveModel::Builder::optimize() {
+        auto optimizeStart = std::chrono::high_resolution_clock::now();
+
+        // Stats describe the full detail level, which is always first.
+        size_t fullIndexCount = lods.empty() ? indices.size() : lods[0].indexCount;
+        auto before = LveMeshOptimizer::analyzeVertexCache(indices.data(), fullIndexCount, vertices.size());
+        // Every level is optimized per submesh, level 0 per meshlet if there are any.
+        std::vector<Lod> ranges;
+        for (const auto &submesh : submeshes) {
+            if (meshlets.empty()) ranges.push_back({submesh.firstIndex, submesh.indexCount, 0.0f});
+            ranges.insert(ranges.end(), submesh.lods.begin(), submesh.lods.end());
+        }
+        if (!meshlets.empty()) {
+            // Meshlets are culled as a whole, so their triangles only get reordered within them.
+            // Each is optimized on a local copy of its few vertices, the optimizer's scratch
+            // space grows with the vertex count.
+            std::vector<Vertex> localVertices;
+            std::vector<uint32_t> localToGlobal;
+            std::vector<uint32_t> globalToLocal(vertices.size(), UINT32_MAX);
+            for (const auto &meshlet : meshlets) {
+                uint32_t *meshletIndices = indices.data() + meshlet.firstIndex;
+                localVertices.clear();
+                localToGlobal.clear();
+                for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+                    uint32_t &index = meshletIndices[i];
+                    if (globalToLocal[index] == UINT32_MAX) {
+                        globalToLocal[index] = static_cast<uint32_t>(localVertices.size());
+                        localVertices.push_back(vertices[index]);
+                        localToGlobal.push_back(index);
+                    }
+                    index = globalToLocal[index];
                 }
-                indices.push_back(uniqueVertices[vertex]);
+                LveMeshOptimizer::optimizeVertexCache(
+                        meshletIndices, meshlet.indexCount, localVertices, options.overdrawThreshold);
+                for (uint32_t i = 0; i < meshlet.indexCount; i++) {
+                    meshletIndices[i] = localToGlobal[meshletIndices[i]];
+                }
+                for (uint32_t index : localToGlobal) {
+                    globalToLocal[index] = UINT32_MAX;
+                }
+            }
+        }
+        for (const auto &range : ranges) {
+            LveMeshOptimizer::optimizeVertexCache(
+                    indices.data() + range.firstIndex, range.indexCount, vertices, options.overdrawThreshold);
+        }
+        LveMeshOptimizer::optimizeVertexFetch(vertices, indices);
+        auto after = LveMeshOptimizer::analyzeVertexCache(indices.data(), fullIndexCount, vertices.size());
+
+        stats.acmrBefore = before.acmr;
+        stats.atvrBefore = before.atvr;
+        stats.acmrAfter = after.acmr;
+        stats.atvrAfter = after.atvr;
+        stats.optimizeMs = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - optimizeStart).count();
+    }
+
+    void LveModel::Builder::computeBounds() {
+        auto boundsStart = std::chrono::high_resolution_clock::now();
+
+        // position is the first member of Vertex; data() stays valid for an empty builder.
+        const auto *positions = reinterpret_cast<const glm::vec3 *>(vertices.data());
+        bounds = LveBounds::compute(positions, vertices.size(), sizeof(Vertex));
+        if (submeshes.size() == 1) {
+            // Level 0 uses every vertex, coarser levels only a subset of them.
+            submeshes[0].bounds = bounds;
+        } else {
+            for (auto &submesh : submeshes) {
+                submesh.bounds = LveBounds::compute(positions, sizeof(Vertex), indices.data() + submesh.firstIndex,
+                                                    submesh.indexCount);
             }
         }
 
+        stats.boundsMs = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - boundsStart).count();
     }
 }
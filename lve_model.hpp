@@ -5,8 +5,11 @@
 #ifndef VULKANTEST_LVE_MODEL_HPP
 #define VULKANTEST_LVE_MODEL_HPP
 
+#include "lve_bounds.hpp"
 #include "lve_buffer.hpp"
 #include "lve_device.hpp"
+#include "lve_geometry_pool.hpp"
+#include "lve_upload_batch.hpp"
 
 
 #define GLM_FORCE_RADIANS
@@ -14,6 +17,7 @@
 #include <glm/glm.hpp>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lve {
@@ -33,36 +37,216 @@ namespace lve {
             }
         };
 
+        // Compact alternative to Vertex, 20 instead of 44 bytes. Positions are 16 bit unorm
+        // relative to the mesh bounds (the model folds the dequantization into the model matrix,
+        // see getPositionDequantization), normals are octahedral encoded, uvs half floats.
+        struct PackedVertex {
+            uint16_t position[4];  // xyz, w is padding
+            uint8_t color[4];      // rgba
+            int16_t normal[2];
+            uint16_t uv[2];
 
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        };
+
+        enum class VertexFormat {
+            Full,    // Vertex
+            Packed,  // PackedVertex, drawn with simple_shader_packed.vert
+        };
+
+        struct LoadOptions {
+            bool useMeshCache = true;    // read/write "<file>.meshcache" instead of reparsing the OBJ
+            bool parallelParse = true;   // LveObjParser instead of the single threaded tinyobj::LoadObj
+            unsigned int parseThreads = 0;  // 0 = one per hardware core
+            bool memoryMapSource = true;    // parallel parser reads through mmap instead of std::ifstream
+            bool optimizeVertexCache = false;  // Tipsify + overdraw sort + vertex fetch reorder
+            float overdrawThreshold = 1.05f;   // ACMR the overdraw sort may cost, see LveMeshOptimizer
+            VertexFormat vertexFormat = VertexFormat::Full;
+            uint32_t lodCount = 1;       // levels including the full mesh, see LveMeshSimplifier
+            float lodReduction = 0.5f;   // triangle ratio between neighbouring levels
+            float lodMaxError = 0.05f;   // per level, relative to the mesh size
+            bool buildMeshlets = false;  // cluster level 0 for CPU culling, closed meshes only
+            // Merge vertices that differ by float noise, see LveVertexWelder. The position
+            // tolerance is relative to the mesh size like lodMaxError; normals and uvs are absolute.
+            bool weldVertices = false;
+            float weldPositionEpsilon = 1e-5f;
+            float weldNormalEpsilon = 0.01f;
+            float weldUvEpsilon = 1e-4f;
+            // Two pass load with bounded memory for huge meshes, see LveStreamingLoader. Only
+            // createModelFromFile streams; the cache, LODs, meshlets, packing and the vertex cache
+            // optimization need the whole mesh in memory and are skipped.
+            bool streamingBuild = false;
+            uint64_t streamingMemoryCap = 256ull * 1024 * 1024;
+        };
+
+        // One level of detail: a range of the shared index buffer.
+        struct Lod {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            float error = 0.0f;  // model space distance to the full mesh, 0 for level 0
+        };
+
+        // A material of the OBJ's .mtl file. textureBinding is the texture the render system draws
+        // it with; the app resolves diffuseTexture to one, -1 leaves the game object's texture.
+        struct Material {
+            std::string name;
+            std::string diffuseTexture;  // map_Kd as written in the .mtl, may be empty
+            int32_t textureBinding = -1;
+        };
+
+        // The triangles of one OBJ object or group that use one material. Submeshes are sorted by
+        // material, and every level of detail keeps them apart.
+        struct Submesh {
+            uint32_t firstIndex = 0;  // level 0
+            uint32_t indexCount = 0;
+            int32_t material = -1;    // into the model's materials, -1 for none
+            LveBounds bounds{};
+            std::vector<Lod> lods{};  // the submesh's ranges in levels 1 and up
+            uint32_t firstMeshlet = 0;
+            uint32_t meshletCount = 0;
+        };
+
+        // A cluster of level 0 triangles with bounds for culling, see LveMeshlets.
+        struct Meshlet {
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+            glm::vec3 center{0.f};
+            float radius = 0.f;
+            glm::vec3 coneAxis{0.f};
+            float coneCutoff = 2.f;  // sine of the normal cone's half angle, above 1 never back facing
+        };
+
+        struct LoadStats {
+            bool cacheHit = false;
+            uint32_t parseThreads = 0;
+            uint64_t sourceBytes = 0;
+            double parseMs = 0.0;  // reading and tokenizing the OBJ, 0 on a cache hit
+            double dedupMs = 0.0;  // building the unique vertex / index lists, 0 on a cache hit
+            double optimizeMs = 0.0;
+            double lodMs = 0.0;
+            double meshletMs = 0.0;
+            double boundsMs = 0.0;
+            double weldMs = 0.0;
+            uint32_t verticesBeforeWeld = 0, verticesAfterWeld = 0;  // only when welding
+            float acmrBefore = 0.0f, acmrAfter = 0.0f;  // FIFO cache ACMR / ATVR, only when optimizing
+            float atvrBefore = 0.0f, atvrAfter = 0.0f;
+            double totalMs = 0.0;
+        };
+
+        // Device local buffers filled outside the Builder path, e.g. by LveStreamingLoader. Full
+        // vertex format, one level of detail.
+        struct GpuMesh {
+            std::unique_ptr<LveBuffer> vertexBuffer;
+            std::unique_ptr<LveBuffer> indexBuffer;
+            uint32_t vertexCount = 0;
+            uint32_t indexCount = 0;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+            LveBounds bounds{};
+        };
 
         struct Builder {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            LoadOptions options{};
+            LoadStats stats{};
+            std::vector<Lod> lods{};  // empty means one level covering all indices
+            std::vector<Meshlet> meshlets{};
+            std::vector<Submesh> submeshes{};  // empty until loadModel
+            std::vector<Material> materials{};
+            LveBounds bounds{};
 
             void loadModel(const std::string &filepath);
+
+          private:
+            void parseObj(const std::string &filepath);
+            void weld();
+            void buildLods();
+            void buildMeshlets();
+            void optimize();
+            void computeBounds();
         };
-        LveModel(LveDevice &device, const LveModel::Builder &builder);
+        // With a pool the geometry is suballocated from its shared buffers when it fits, otherwise
+        // (and without a pool) the model owns its own vertex and index buffer. The copies are
+        // recorded into batch, which must be submitted before the model is drawn; without a
+        // batch the model submits them itself and waits.
+        LveModel(LveDevice &device, const LveModel::Builder &builder, LveGeometryPool *pool = nullptr,
+                 LveUploadBatch *batch = nullptr);
+        LveModel(LveDevice &device, GpuMesh &&mesh);
         ~LveModel();
 
         LveModel(const LveModel&) = delete;
         LveModel &operator=(const LveModel&) = delete;
 
         static std::unique_ptr<LveModel> createModelFromFile(LveDevice &device, const std::string &filepath);
+        static std::unique_ptr<LveModel> createModelFromFile(
+                LveDevice &device, const std::string &filepath, const LoadOptions &options,
+                LveGeometryPool *pool = nullptr);
+        // Uploads a model loaded by builder.loadModel(filepath), e.g. on another thread.
+        static std::unique_ptr<LveModel> createModelFromBuilder(
+                LveDevice &device, const std::string &filepath, const Builder &builder,
+                LveGeometryPool *pool = nullptr, LveUploadBatch *batch = nullptr);
 
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
+        void draw(VkCommandBuffer commandBuffer, uint32_t lod);
+        void drawRange(VkCommandBuffer commandBuffer, uint32_t firstIndex, uint32_t indexCount);
+
+        uint32_t getLodCount() const { return static_cast<uint32_t>(lods.size()); }
+        const Lod &getLod(uint32_t lod) const { return lods[lod]; }
+        // Model space bounds of all vertices, for culling, picking and choosing a LOD.
+        const LveBounds &getBounds() const { return bounds; }
+        const glm::vec3 &getBoundsCenter() const { return bounds.center; }
+        float getBoundsRadius() const { return bounds.radius; }
+        const std::vector<Submesh> &getSubmeshes() const { return submeshes; }
+        // Index range of a submesh in the given level, clamped like draw().
+        Lod getSubmeshRange(const Submesh &submesh, uint32_t lod) const;
+        const std::vector<Material> &getMaterials() const { return materials; }
+        void setMaterialTexture(uint32_t material, int32_t textureBinding) {
+            materials[material].textureBinding = textureBinding;
+        }
+        const std::vector<Meshlet> &getMeshlets() const { return meshlets; }
+
+        VertexFormat getVertexFormat() const { return vertexFormat; }
+        // Maps stored positions to model space; identity unless the vertices are packed.
+        const glm::mat4 &getPositionDequantization() const { return positionDequantization; }
+        VkIndexType getIndexType() const { return indexType; }
+        VkDeviceSize getVertexBufferSize() const { return vertexBufferSize; }
+        VkDeviceSize getIndexBufferSize() const { return indexBufferSize; }
+        // The pool the geometry lives in, nullptr if the model owns its buffers. Pooled models
+        // are bound through the pool, see LveGeometryPool::bind.
+        LveGeometryPool *getGeometryPool() const { return geometryPool; }
+
       private:
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        void createVertexBuffers(const std::vector<Vertex> &vertices, VertexFormat format, LveUploadBatch &batch);
+        void createIndexBuffers(const std::vector<uint32_t> &indices, LveUploadBatch &batch);
+        void uploadVertexData(const void *data, uint32_t vertexSize, LveUploadBatch &batch);
+        bool allocateFromPool(LveGeometryPool &pool, const Builder &builder);
 
         LveDevice& lveDevice;
 
+        LveGeometryPool *geometryPool = nullptr;
+        LveGeometryPool::Allocation poolAllocation{};
+        int32_t baseVertex = 0;  // of the pool allocation, added to every draw
+        uint32_t baseIndex = 0;
+
+        VertexFormat vertexFormat = VertexFormat::Full;
+        glm::mat4 positionDequantization{1.f};
         std::unique_ptr<LveBuffer> vertexBuffer;
         uint32_t vertexCount;
+        VkDeviceSize vertexBufferSize = 0;
 
         bool hasIndexBuffer = false;
         std::unique_ptr<LveBuffer> indexBuffer;
         uint32_t indexCount;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;  // UINT16 whenever the vertex count allows it
+        VkDeviceSize indexBufferSize = 0;
+
+        std::vector<Lod> lods;
+        std::vector<Meshlet> meshlets;
+        std::vector<Submesh> submeshes;
+        std::vector<Material> materials;
+        LveBounds bounds{};
     };
 }
 
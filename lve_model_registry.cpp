@@ -0,0 +1,76 @@
+#include "lve_model_registry.hpp"
+
+// std
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+
+namespace lve {
+
+    std::string LveModelRegistry::makeKey(const std::string &filepath, const LveModel::LoadOptions &options) {
+        // Every option that changes the built model belongs here.
+        std::ostringstream key;
+        key << std::filesystem::weakly_canonical(filepath).string()
+            << "|vc" << options.optimizeVertexCache << ':' << options.overdrawThreshold
+            << "|vf" << static_cast<int>(options.vertexFormat)
+            << "|lod" << options.lodCount << ':' << options.lodReduction << ':' << options.lodMaxError
+            << "|ml" << options.buildMeshlets
+            << "|wd" << options.weldVertices << ':' << options.weldPositionEpsilon << ':'
+            << options.weldNormalEpsilon << ':' << options.weldUvEpsilon
+            << "|st" << options.streamingBuild;
+        return key.str();
+    }
+
+    std::shared_ptr<LveModel> LveModelRegistry::load(const std::string &filepath) {
+        return load(filepath, LveModel::LoadOptions{});
+    }
+
+    std::shared_ptr<LveModel> LveModelRegistry::load(const std::string &filepath, const LveModel::LoadOptions &options) {
+        if (auto model = find(filepath, options)) {
+            return model;
+        }
+
+        auto loadStart = std::chrono::high_resolution_clock::now();
+        std::shared_ptr<LveModel> model = LveModel::createModelFromFile(lveDevice, filepath, options, geometryPool);
+        add(filepath, options, model, std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - loadStart).count());
+        return model;
+    }
+
+    std::shared_ptr<LveModel> LveModelRegistry::find(const std::string &filepath, const LveModel::LoadOptions &options) {
+        stats.requests++;
+        auto it = models.find(makeKey(filepath, options));
+        if (it == models.end()) return nullptr;
+        auto model = it->second.model.lock();
+        if (model) {
+            stats.bytesSaved += it->second.bytes;
+            stats.loadMsSaved += it->second.loadMs;
+        }
+        return model;
+    }
+
+    void LveModelRegistry::add(const std::string &filepath, const LveModel::LoadOptions &options,
+                               const std::shared_ptr<LveModel> &model, double loadMs) {
+        Entry &entry = models[makeKey(filepath, options)];
+        entry.model = model;
+        entry.bytes = model->getVertexBufferSize() + model->getIndexBufferSize();
+        entry.loadMs = loadMs;
+        stats.loads++;
+    }
+
+    long LveModelRegistry::getUseCount(const std::string &filepath, const LveModel::LoadOptions &options) const {
+        auto it = models.find(makeKey(filepath, options));
+        return it == models.end() ? 0 : it->second.model.use_count();
+    }
+
+    void LveModelRegistry::releaseUnused() {
+        for (auto it = models.begin(); it != models.end();) {
+            if (it->second.model.expired()) {
+                it = models.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+}  // namespace lve
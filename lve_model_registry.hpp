@@ -0,0 +1,75 @@
+#ifndef VULKANTEST_LVE_MODEL_REGISTRY_HPP
+#define VULKANTEST_LVE_MODEL_REGISTRY_HPP
+
+#include "lve_device.hpp"
+#include "lve_geometry_pool.hpp"
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace lve {
+
+    /**
+     * Hands out shared LveModels so that every asset is parsed and uploaded once.
+     *
+     * Models are keyed by their canonical path and the load options that change the resulting
+     * geometry (options that only change how the file is read, like the parse thread count, are
+     * ignored). The registry only keeps weak references: a model is freed once the last game
+     * object using it is gone, and the next request loads it again.
+     */
+    class LveModelRegistry {
+    public:
+        struct Stats {
+            uint32_t requests = 0;
+            uint32_t loads = 0;        // requests that had to load the file
+            uint64_t bytesSaved = 0;   // GPU buffer bytes shared instead of uploaded again
+            double loadMsSaved = 0.0;  // load time of the original load, per shared request
+        };
+
+        // Loaded models suballocate their buffers from pool when one is given.
+        explicit LveModelRegistry(LveDevice &device, LveGeometryPool *pool = nullptr)
+                : lveDevice{device}, geometryPool{pool} {}
+
+        LveModelRegistry(const LveModelRegistry&) = delete;
+        LveModelRegistry &operator=(const LveModelRegistry&) = delete;
+
+        std::shared_ptr<LveModel> load(const std::string &filepath);
+        std::shared_ptr<LveModel> load(const std::string &filepath, const LveModel::LoadOptions &options);
+
+        // The loaded model or nullptr, counted as a request. For loaders that build models
+        // themselves (LveModelStreamer), which then hand them over with add().
+        std::shared_ptr<LveModel> find(const std::string &filepath, const LveModel::LoadOptions &options);
+        void add(const std::string &filepath, const LveModel::LoadOptions &options,
+                 const std::shared_ptr<LveModel> &model, double loadMs);
+
+        // Two requests with the same key share one model.
+        static std::string makeKey(const std::string &filepath, const LveModel::LoadOptions &options);
+
+        // Live handles to the model, 0 if it isn't loaded.
+        long getUseCount(const std::string &filepath, const LveModel::LoadOptions &options) const;
+        // Drops the entries of models nobody uses anymore.
+        void releaseUnused();
+
+        const Stats &getStats() const { return stats; }
+        size_t getModelCount() const { return models.size(); }
+        LveGeometryPool *getGeometryPool() const { return geometryPool; }
+
+    private:
+        struct Entry {
+            std::weak_ptr<LveModel> model;
+            VkDeviceSize bytes = 0;
+            double loadMs = 0.0;
+        };
+
+        LveDevice &lveDevice;
+        LveGeometryPool *geometryPool;
+        std::unordered_map<std::string, Entry> models;
+        Stats stats;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MODEL_REGISTRY_HPP
@@ -0,0 +1,190 @@
+#include "lve_model_streamer.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace lve {
+
+    namespace {
+
+        // Unit cube with per face normals, the stand-in for models that are still loading.
+        LveModel::Builder makeProxyCube() {
+            LveModel::Builder builder{};
+            const glm::vec3 color{0.5f, 0.5f, 0.5f};
+            for (int axis = 0; axis < 3; axis++) {
+                for (float side : {-1.f, 1.f}) {
+                    glm::vec3 normal{0.f};
+                    normal[axis] = side;
+                    glm::vec3 u{0.f}, v{0.f};
+                    u[(axis + 1) % 3] = 1.f;
+                    v[(axis + 2) % 3] = 1.f;
+
+                    auto first = static_cast<uint32_t>(builder.vertices.size());
+                    const glm::vec2 corners[4] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+                    for (const auto &corner : corners) {
+                        glm::vec3 position = normal + corner.x * u + corner.y * v;
+                        builder.vertices.push_back({position, color, normal, 0.5f * (corner + glm::vec2{1.f})});
+                    }
+                    for (uint32_t index : {0u, 1u, 2u, 2u, 3u, 0u}) {
+                        builder.indices.push_back(first + index);
+                    }
+                }
+            }
+            return builder;
+        }
+
+    }  // namespace
+
+    LveModelStreamer::LveModelStreamer(LveDevice &device, LveModelRegistry &registry)
+            : lveDevice{device}, registry{registry}, uploadBatch{device} {
+        proxy = std::make_shared<LveModel>(lveDevice, makeProxyCube(), registry.getGeometryPool());
+        worker = std::thread{&LveModelStreamer::workerLoop, this};
+    }
+
+    LveModelStreamer::~LveModelStreamer() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        worker.join();
+    }
+
+    std::shared_ptr<LveModelStreamer::Handle> LveModelStreamer::loadAsync(
+            const std::string &filepath, const LveModel::LoadOptions &options, ReadyCallback onReady) {
+        stats.requested++;
+        auto handle = std::make_shared<Handle>();
+        handle->proxy = proxy;
+        handle->onReady = std::move(onReady);
+
+        // Resolved in the next update() so callbacks always run at the same point of the frame.
+        std::string key = LveModelRegistry::makeKey(filepath, options);
+        auto &handles = waiting[key];
+        bool queued = !handles.empty();
+        handles.push_back(handle);
+        if (queued) return handle;
+
+        if (auto model = registry.find(filepath, options)) {
+            std::lock_guard<std::mutex> lock{mutex};
+            results.push_back({{key, filepath, options}, nullptr, std::move(model), {}, 0.0});
+            return handle;
+        }
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            jobs.push_back({key, filepath, options});
+        }
+        jobAvailable.notify_one();
+        return handle;
+    }
+
+    uint32_t LveModelStreamer::update() {
+        auto updateStart = std::chrono::high_resolution_clock::now();
+        uint32_t resolved = 0;
+        for (size_t i = 0; i < uploads.size();) {
+            if (uploads[i].token && !uploads[i].token->isComplete()) {
+                i++;
+                continue;
+            }
+            Upload upload = std::move(uploads[i]);
+            uploads.erase(uploads.begin() + static_cast<std::ptrdiff_t>(i));
+            resolved += static_cast<uint32_t>(waiting[upload.job.key].size());
+            registry.add(upload.job.filepath, upload.job.options, upload.model, upload.loadMs);
+            stats.loaded++;
+            resolve(upload.job, upload.model);
+        }
+
+        size_t firstStarted = uploads.size();
+        for (uint32_t started = 0; started < uploadsPerFrame;) {
+            Result result;
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                if (results.empty()) break;
+                result = std::move(results.front());
+                results.pop_front();
+            }
+
+            auto &handles = waiting[result.job.key];
+            if (result.builder) {
+                std::shared_ptr<LveModel> model =
+                        LveModel::createModelFromBuilder(lveDevice, result.job.filepath, *result.builder,
+                                                         registry.getGeometryPool(), &uploadBatch);
+                uploads.push_back({std::move(result.job), std::move(model), nullptr, result.loadMs});
+                started++;
+            } else if (result.model) {
+                resolved += static_cast<uint32_t>(handles.size());
+                resolve(result.job, result.model);
+            } else {
+                std::cerr << "Streaming " << result.job.filepath << " failed: " << result.error << std::endl;
+                stats.failed++;
+                for (auto &handle : handles) handle->failed = true;
+                waiting.erase(result.job.key);
+            }
+        }
+        if (auto token = uploadBatch.submit()) {
+            for (size_t i = firstStarted; i < uploads.size(); i++) uploads[i].token = token;
+        }
+        if (resolved > 0 || firstStarted < uploads.size()) {
+            stats.maxUploadMs = std::max(stats.maxUploadMs, std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - updateStart).count());
+        }
+        return resolved;
+    }
+
+    void LveModelStreamer::resolve(const Job &job, const std::shared_ptr<LveModel> &model) {
+        auto handles = std::move(waiting[job.key]);
+        waiting.erase(job.key);
+        for (size_t i = 0; i < handles.size(); i++) {
+            // The first handle accounts for the load, the others share it like registry hits.
+            if (i > 0) registry.find(job.filepath, job.options);
+            handles[i]->model = model;
+            if (handles[i]->onReady) handles[i]->onReady(model);
+        }
+    }
+
+    void LveModelStreamer::recordFrameTime(float frameTime) {
+        double frameMs = frameTime * 1000.0;
+        bool streaming = !isIdle();
+        if (streaming) {
+            stats.streamingFrames++;
+            stats.worstFrameMs = std::max(stats.worstFrameMs, frameMs);
+            if (stats.averageFrameMs > 0.0 && frameMs > SPIKE_FACTOR * stats.averageFrameMs) {
+                stats.spikeFrames++;
+            }
+        }
+        // Exponential moving average, seeded with the first frame.
+        stats.averageFrameMs = stats.averageFrameMs > 0.0 ? 0.95 * stats.averageFrameMs + 0.05 * frameMs : frameMs;
+    }
+
+    void LveModelStreamer::workerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            Result result{};
+            auto loadStart = std::chrono::high_resolution_clock::now();
+            try {
+                result.builder = std::make_unique<LveModel::Builder>();
+                result.builder->options = job.options;
+                result.builder->loadModel(job.filepath);
+            } catch (const std::exception &e) {
+                result.builder.reset();
+                result.error = e.what();
+            }
+            result.loadMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - loadStart).count();
+            result.job = std::move(job);
+
+            std::lock_guard<std::mutex> lock{mutex};
+            results.push_back(std::move(result));
+        }
+    }
+
+}  // namespace lve
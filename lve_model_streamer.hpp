@@ -0,0 +1,137 @@
+#ifndef VULKANTEST_LVE_MODEL_STREAMER_HPP
+#define VULKANTEST_LVE_MODEL_STREAMER_HPP
+
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+#include "lve_model_registry.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Loads models in the background.
+     *
+     * A worker thread runs LveModel::Builder::loadModel (parse, cache, LODs, ...) and the render
+     * thread uploads the finished builders in update(), a few per frame, since the command pool
+     * isn't thread safe. The uploads of one update() go out as one LveUploadBatch submission that
+     * the render thread never waits on; later update() calls resolve the handles once its fence
+     * has signaled. Until then a handle resolves to a shared proxy cube spanning [-1, 1], drawn
+     * with the object's transform.
+     *
+     * Requests go through the registry, so repeated loads of one asset share a job and a model.
+     * Everything except the worker's loadModel call happens on the thread calling update().
+     */
+    class LveModelStreamer {
+    public:
+        using ReadyCallback = std::function<void(const std::shared_ptr<LveModel> &model)>;
+
+        class Handle {
+        public:
+            bool isReady() const { return model != nullptr; }
+            bool hasFailed() const { return failed; }
+            // The loaded model once ready, the proxy before (and after a failed load).
+            const std::shared_ptr<LveModel> &get() const { return model ? model : proxy; }
+
+        private:
+            friend class LveModelStreamer;
+            std::shared_ptr<LveModel> proxy;
+            std::shared_ptr<LveModel> model;
+            bool failed = false;
+            ReadyCallback onReady;
+        };
+
+        struct Stats {
+            uint32_t requested = 0;
+            uint32_t loaded = 0;     // models built and uploaded by the streamer
+            uint32_t failed = 0;
+            double maxUploadMs = 0.0;  // longest update() spent uploading
+            // Frames recorded while jobs were in flight, and those that took more than
+            // SPIKE_FACTOR times the running average.
+            uint32_t streamingFrames = 0;
+            uint32_t spikeFrames = 0;
+            double worstFrameMs = 0.0;
+            double averageFrameMs = 0.0;
+        };
+
+        static constexpr float SPIKE_FACTOR = 2.0f;
+
+        LveModelStreamer(LveDevice &device, LveModelRegistry &registry);
+        ~LveModelStreamer();
+
+        LveModelStreamer(const LveModelStreamer&) = delete;
+        LveModelStreamer &operator=(const LveModelStreamer&) = delete;
+
+        // onReady runs inside update() with the loaded model; it isn't called on failure.
+        std::shared_ptr<Handle> loadAsync(const std::string &filepath, const LveModel::LoadOptions &options,
+                                          ReadyCallback onReady = {});
+
+        // Resolves the models whose uploads completed, running their callbacks, and starts the
+        // uploads of at most uploadsPerFrame finished models. Returns the number of requests resolved.
+        uint32_t update();
+        // Feeds the frame time statistics, call once per frame.
+        void recordFrameTime(float frameTime);
+
+        bool isIdle() const { return waiting.empty(); }
+        const Stats &getStats() const { return stats; }
+        const std::shared_ptr<LveModel> &getProxy() const { return proxy; }
+
+        uint32_t uploadsPerFrame = 1;
+
+    private:
+        struct Job {
+            std::string key;
+            std::string filepath;
+            LveModel::LoadOptions options;
+        };
+
+        struct Result {
+            Job job;
+            std::unique_ptr<LveModel::Builder> builder;  // nullptr if loading threw
+            std::shared_ptr<LveModel> model;             // set instead if the registry had it
+            std::string error;
+            double loadMs = 0.0;
+        };
+
+        // A model whose buffers are still being copied, resolved once the token completes. No token
+        // when the batch wrote them in place (unified memory): ready on the next update.
+        struct Upload {
+            Job job;
+            std::shared_ptr<LveModel> model;
+            std::shared_ptr<LveUploadBatch::Token> token;
+            double loadMs = 0.0;
+        };
+
+        void workerLoop();
+        void resolve(const Job &job, const std::shared_ptr<LveModel> &model);
+
+        LveDevice &lveDevice;
+        LveModelRegistry &registry;
+        std::shared_ptr<LveModel> proxy;
+
+        // Render thread only: handles waiting for each job, and uploads in flight.
+        std::unordered_map<std::string, std::vector<std::shared_ptr<Handle>>> waiting;
+        LveUploadBatch uploadBatch;
+        std::vector<Upload> uploads;
+        Stats stats;
+
+        std::mutex mutex;
+        std::condition_variable jobAvailable;
+        std::deque<Job> jobs;
+        std::deque<Result> results;
+        bool stopping = false;
+        std::thread worker;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_MODEL_STREAMER_HPP
@@ -0,0 +1,843 @@
+#include "lve_obj_parser.hpp"
+#include "lve_mapped_file.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// std
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace lve {
+
+    namespace {
+
+        // Below this much data per chunk, spawning another thread costs more than it saves.
+        constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+        // Smoothing group of faces that appear before the first 's' statement of a chunk; the
+        // real value is inherited from the preceding chunk during the merge.
+        constexpr uint32_t INHERIT_SMOOTHING = UINT32_MAX;
+
+        enum RelativeBits : uint32_t {
+            RELATIVE_V = 1,
+            RELATIVE_VT = 2,
+            RELATIVE_VN = 4,
+        };
+
+        // One face corner. Relative indices are stored against the chunk's own element counts
+        // and rebased once the counts of all preceding chunks are known.
+        struct RawIndex {
+            int v;
+            int vt;
+            int vn;
+            uint32_t relative;
+        };
+
+        struct Statement {
+            enum Kind { Group, Object, UseMtl, MtlLib } kind;
+            size_t face;  // number of faces of the chunk that precede the statement
+            std::string text;
+        };
+
+        struct Segment {
+            size_t shape;
+            size_t dstTriangle;
+            size_t firstTriangle;
+            size_t triangleCount;
+            int materialId;
+        };
+
+        struct Chunk {
+            const char *begin = nullptr;
+            const char *end = nullptr;
+            size_t lineCount = 0;
+
+            std::vector<float> positions;
+            std::vector<float> colors;
+            std::vector<float> normals;
+            std::vector<float> texcoords;
+
+            std::vector<RawIndex> corners;
+            std::vector<uint32_t> faceSizes;
+            std::vector<uint32_t> faceSmoothing;
+            std::vector<Statement> statements;
+            uint32_t smoothing = INHERIT_SMOOTHING;  // state at the end of the chunk
+
+            // filled during the merge
+            size_t positionBase = 0;
+            size_t normalBase = 0;
+            size_t texcoordBase = 0;
+            std::vector<tinyobj::index_t> triangles;
+            std::vector<uint32_t> triangleSmoothing;
+            std::vector<size_t> faceTriangleStart;
+            std::vector<Segment> segments;
+
+            uint32_t zeroIndices = 0;
+            uint32_t degenerateFaces = 0;
+            uint32_t polygons = 0;
+            uint32_t skippedElements = 0;
+            uint32_t emptyGroupNames = 0;
+
+            std::string error;
+            size_t errorLine = 0;
+        };
+
+        // Runs fn on every chunk, one thread per chunk. Errors are recorded on the chunk so a
+        // worker never throws across the thread boundary.
+        void forEachChunk(std::vector<Chunk> &chunks, const std::function<void(Chunk &)> &fn) {
+            auto guarded = [&fn](Chunk &chunk) {
+                try {
+                    fn(chunk);
+                } catch (const std::exception &e) {
+                    chunk.error = e.what();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(chunks.size());
+            for (size_t i = 1; i < chunks.size(); i++) {
+                workers.emplace_back(guarded, std::ref(chunks[i]));
+            }
+            guarded(chunks[0]);
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        }
+
+        void throwOnChunkError(const std::vector<Chunk> &chunks, const std::string &filepath) {
+            size_t lineBase = 0;
+            for (const auto &chunk : chunks) {
+                if (!chunk.error.empty()) {
+                    std::string where = chunk.errorLine > 0
+                            ? " (line " + std::to_string(lineBase + chunk.errorLine) + ")" : "";
+                    throw std::runtime_error(filepath + ": " + chunk.error + where);
+                }
+                lineBase += chunk.lineCount;
+            }
+        }
+
+        inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+        // Returns the first '\n' in [p, end), or end. Lines are short, so an inline 16 byte
+        // scan beats a memchr call per line.
+        inline const char *findNewline(const char *p, const char *end) {
+#if defined(__SSE2__)
+            const __m128i newline = _mm_set1_epi8('\n');
+            while (end - p >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+                if (mask != 0) return p + __builtin_ctz(static_cast<unsigned int>(mask));
+                p += 16;
+            }
+#endif
+            while (p < end && *p != '\n') p++;
+            return p;
+        }
+
+        inline const char *skipSpace(const char *p, const char *end) {
+            while (p < end && isSpace(*p)) p++;
+            return p;
+        }
+
+        // Returns the first space, tab or '\r' in [p, end), or end.
+        inline const char *tokenEnd(const char *p, const char *end) {
+#if defined(__SSE2__)
+            const __m128i space = _mm_set1_epi8(' ');
+            const __m128i tab = _mm_set1_epi8('\t');
+            const __m128i carriageReturn = _mm_set1_epi8('\r');
+            while (end - p >= 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+                                            _mm_cmpeq_epi8(block, carriageReturn));
+                int mask = _mm_movemask_epi8(hits);
+                if (mask != 0) return p + __builtin_ctz(static_cast<unsigned int>(mask));
+                p += 16;
+            }
+#endif
+            while (p < end && !isSpace(*p) && *p != '\r') p++;
+            return p;
+        }
+
+        // Parses one whitespace separated real. The caller keeps its default on failure, the
+        // same way tinyobj's parseReal does. from_chars is locale independent, needs no NUL
+        // terminator (so it works straight on a file mapping) and rounds like strtod.
+        inline bool parseFloat(const char *&p, const char *end, float &value) {
+            p = skipSpace(p, end);
+            const char *last = tokenEnd(p, end);
+            if (p == last) return false;
+
+            const char *first = *p == '+' ? p + 1 : p;
+            double result = 0.0;
+            auto [parsed, ec] = std::from_chars(first, last, result);
+            bool ok = ec == std::errc() && parsed == last;
+            p = last;
+            if (ok) value = static_cast<float>(result);
+            return ok;
+        }
+
+        // atoi semantics, the way tinyobj reads face indices.
+        inline int parseInt(const char *p, const char *end) {
+            while (p < end && isSpace(*p)) p++;
+            bool negative = false;
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = *p == '-';
+                p++;
+            }
+            int value = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                value = value * 10 + (*p - '0');
+                p++;
+            }
+            return negative ? -value : value;
+        }
+
+        inline const char *skipIndexField(const char *p, const char *end) {
+            while (p < end && *p != '/' && !isSpace(*p) && *p != '\r') p++;
+            return p;
+        }
+
+        // Parses "v", "v/vt", "v//vn" or "v/vt/vn". Returns false on a zero or missing
+        // position index.
+        bool parseCorner(const char *&p, const char *end, Chunk &chunk, RawIndex &corner) {
+            corner = {-1, -1, -1, 0};
+
+            auto fixIndex = [&chunk](int idx, size_t localCount, uint32_t relativeBit,
+                                     bool allowZero, int &out, uint32_t &relative) {
+                if (idx > 0) {
+                    out = idx - 1;
+                    return true;
+                }
+                if (idx == 0) {
+                    chunk.zeroIndices++;
+                    out = -1;
+                    return allowZero;
+                }
+                out = static_cast<int>(localCount) + idx;
+                relative |= relativeBit;
+                return true;
+            };
+
+            size_t positionCount = chunk.positions.size() / 3;
+            size_t normalCount = chunk.normals.size() / 3;
+            size_t texcoordCount = chunk.texcoords.size() / 2;
+
+            if (!fixIndex(parseInt(p, end), positionCount, RELATIVE_V, false, corner.v, corner.relative)) {
+                return false;
+            }
+            p = skipIndexField(p, end);
+            if (p == end || *p != '/') return true;
+            p++;
+
+            if (p < end && *p == '/') {
+                p++;
+                fixIndex(parseInt(p, end), normalCount, RELATIVE_VN, true, corner.vn, corner.relative);
+                p = skipIndexField(p, end);
+                return true;
+            }
+
+            fixIndex(parseInt(p, end), texcoordCount, RELATIVE_VT, true, corner.vt, corner.relative);
+            p = skipIndexField(p, end);
+            if (p == end || *p != '/') return true;
+            p++;
+
+            fixIndex(parseInt(p, end), normalCount, RELATIVE_VN, true, corner.vn, corner.relative);
+            p = skipIndexField(p, end);
+            return true;
+        }
+
+        void parseLine(Chunk &chunk, const char *p, const char *end) {
+            p = skipSpace(p, end);
+            if (p == end || *p == '#') return;
+
+            size_t length = static_cast<size_t>(end - p);
+            auto startsWith = [&](const char *keyword, size_t n) {
+                return length > n && std::memcmp(p, keyword, n) == 0 && isSpace(p[n]);
+            };
+
+            if (startsWith("v", 1)) {
+                p += 2;
+                float x = 0.0f, y = 0.0f, z = 0.0f;
+                parseFloat(p, end, x);
+                parseFloat(p, end, y);
+                parseFloat(p, end, z);
+                chunk.positions.insert(chunk.positions.end(), {x, y, z});
+
+                float r = 1.0f, g = 1.0f, b = 1.0f;
+                if (!(parseFloat(p, end, r) && parseFloat(p, end, g) && parseFloat(p, end, b))) {
+                    r = g = b = 1.0f;
+                }
+                chunk.colors.insert(chunk.colors.end(), {r, g, b});
+                return;
+            }
+
+            if (startsWith("vn", 2)) {
+                p += 3;
+                float x = 0.0f, y = 0.0f, z = 0.0f;
+                parseFloat(p, end, x);
+                parseFloat(p, end, y);
+                parseFloat(p, end, z);
+                chunk.normals.insert(chunk.normals.end(), {x, y, z});
+                return;
+            }
+
+            if (startsWith("vt", 2)) {
+                p += 3;
+                float u = 0.0f, v = 0.0f;
+                parseFloat(p, end, u);
+                parseFloat(p, end, v);
+                chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+                return;
+            }
+
+            if (startsWith("f", 1)) {
+                p = skipSpace(p + 2, end);
+                size_t firstCorner = chunk.corners.size();
+                while (p < end && *p != '\r') {
+                    RawIndex corner{};
+                    if (!parseCorner(p, end, chunk, corner)) {
+                        chunk.error = "failed to parse 'f' line (zero or invalid vertex index)";
+                        chunk.errorLine = chunk.lineCount;
+                        return;
+                    }
+                    chunk.corners.push_back(corner);
+                    p = skipSpace(p, end);
+                }
+                chunk.faceSizes.push_back(static_cast<uint32_t>(chunk.corners.size() - firstCorner));
+                chunk.faceSmoothing.push_back(chunk.smoothing);
+                return;
+            }
+
+            if (startsWith("l", 1) || startsWith("p", 1)) {
+                chunk.skippedElements++;
+                return;
+            }
+
+            if (startsWith("usemtl", 6)) {
+                p = skipSpace(p + 6, end);
+                chunk.statements.push_back({Statement::UseMtl, chunk.faceSizes.size(),
+                                            std::string(p, tokenEnd(p, end))});
+                return;
+            }
+
+            if (startsWith("mtllib", 6)) {
+                chunk.statements.push_back({Statement::MtlLib, chunk.faceSizes.size(), std::string(p + 7, end)});
+                return;
+            }
+
+            if (startsWith("g", 1)) {
+                std::string name;
+                p += 2;
+                while ((p = skipSpace(p, end)) < end && *p != '\r') {
+                    const char *last = tokenEnd(p, end);
+                    if (!name.empty()) name += ' ';
+                    name.append(p, last);
+                    p = last;
+                }
+                if (name.empty()) chunk.emptyGroupNames++;
+                chunk.statements.push_back({Statement::Group, chunk.faceSizes.size(), name});
+                return;
+            }
+
+            if (startsWith("o", 1)) {
+                chunk.statements.push_back({Statement::Object, chunk.faceSizes.size(), std::string(p + 2, end)});
+                return;
+            }
+
+            if (startsWith("s", 1)) {
+                p = skipSpace(p + 2, end);
+                if (p == end || *p == '\r') return;
+                if (end - p >= 3 && std::memcmp(p, "off", 3) == 0) {
+                    chunk.smoothing = 0;
+                } else {
+                    int group = parseInt(p, end);
+                    chunk.smoothing = group < 0 ? 0 : static_cast<uint32_t>(group);
+                }
+                return;
+            }
+
+            // Everything else ('vw', 't', unknown statements) is ignored, as tinyobj does.
+        }
+
+        void parseChunk(Chunk &chunk) {
+            const char *p = chunk.begin;
+            while (p < chunk.end && chunk.error.empty()) {
+                const char *lineEnd = findNewline(p, chunk.end);
+                const char *contentEnd = lineEnd;
+                if (contentEnd > p && contentEnd[-1] == '\r') contentEnd--;
+
+                chunk.lineCount++;
+                parseLine(chunk, p, contentEnd);
+                p = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+            }
+        }
+
+        // Resolves the chunk's relative indices against the global counts and copies its
+        // vertex data into the merged attribute arrays.
+        void rebaseChunk(Chunk &chunk, tinyobj::attrib_t &attrib, uint32_t inheritedSmoothing) {
+            std::copy(chunk.positions.begin(), chunk.positions.end(), attrib.vertices.begin() + 3 * chunk.positionBase);
+            std::copy(chunk.colors.begin(), chunk.colors.end(), attrib.colors.begin() + 3 * chunk.positionBase);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), attrib.normals.begin() + 3 * chunk.normalBase);
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), attrib.texcoords.begin() + 2 * chunk.texcoordBase);
+
+            int positionCount = static_cast<int>(attrib.vertices.size() / 3);
+            int normalCount = static_cast<int>(attrib.normals.size() / 3);
+            int texcoordCount = static_cast<int>(attrib.texcoords.size() / 2);
+
+            for (auto &corner : chunk.corners) {
+                if (corner.relative & RELATIVE_V) corner.v += static_cast<int>(chunk.positionBase);
+                if (corner.relative & RELATIVE_VN) corner.vn += static_cast<int>(chunk.normalBase);
+                if (corner.relative & RELATIVE_VT) corner.vt += static_cast<int>(chunk.texcoordBase);
+
+                if (corner.v < 0 || corner.v >= positionCount ||
+                    corner.vn < -1 || corner.vn >= normalCount ||
+                    corner.vt < -1 || corner.vt >= texcoordCount) {
+                    chunk.error = "face index out of range";
+                    return;
+                }
+            }
+
+            for (auto &smoothing : chunk.faceSmoothing) {
+                if (smoothing != INHERIT_SMOOTHING) break;
+                smoothing = inheritedSmoothing;
+            }
+        }
+
+        void triangulateChunk(Chunk &chunk, const std::vector<float> &positions) {
+            auto toIndex = [](const RawIndex &corner) {
+                tinyobj::index_t index;
+                index.vertex_index = corner.v;
+                index.normal_index = corner.vn;
+                index.texcoord_index = corner.vt;
+                return index;
+            };
+            auto emit = [&](const RawIndex &a, const RawIndex &b, const RawIndex &c, uint32_t smoothing) {
+                chunk.triangles.push_back(toIndex(a));
+                chunk.triangles.push_back(toIndex(b));
+                chunk.triangles.push_back(toIndex(c));
+                chunk.triangleSmoothing.push_back(smoothing);
+            };
+
+            chunk.triangles.reserve(chunk.corners.size() * 3 / 2);
+            chunk.triangleSmoothing.reserve(chunk.corners.size() / 2);
+            chunk.faceTriangleStart.resize(chunk.faceSizes.size() + 1);
+
+            size_t corner = 0;
+            for (size_t face = 0; face < chunk.faceSizes.size(); face++) {
+                chunk.faceTriangleStart[face] = chunk.triangleSmoothing.size();
+                uint32_t size = chunk.faceSizes[face];
+                uint32_t smoothing = chunk.faceSmoothing[face];
+                const RawIndex *c = chunk.corners.data() + corner;
+                corner += size;
+
+                if (size < 3) {
+                    chunk.degenerateFaces++;
+                } else if (size == 3) {
+                    emit(c[0], c[1], c[2], smoothing);
+                } else if (size == 4) {
+                    // Split along the shorter diagonal, exactly like tinyobj.
+                    auto position = [&positions](int i, int axis) { return positions[3 * i + axis]; };
+                    float e02x = position(c[2].v, 0) - position(c[0].v, 0);
+                    float e02y = position(c[2].v, 1) - position(c[0].v, 1);
+                    float e02z = position(c[2].v, 2) - position(c[0].v, 2);
+                    float e13x = position(c[3].v, 0) - position(c[1].v, 0);
+                    float e13y = position(c[3].v, 1) - position(c[1].v, 1);
+                    float e13z = position(c[3].v, 2) - position(c[1].v, 2);
+                    float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+                    float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+                    if (sqr02 < sqr13) {
+                        emit(c[0], c[1], c[2], smoothing);
+                        emit(c[0], c[2], c[3], smoothing);
+                    } else {
+                        emit(c[0], c[1], c[3], smoothing);
+                        emit(c[1], c[2], c[3], smoothing);
+                    }
+                } else {
+                    chunk.polygons++;
+                    for (uint32_t i = 1; i + 1 < size; i++) {
+                        emit(c[0], c[i], c[i + 1], smoothing);
+                    }
+                }
+            }
+            chunk.faceTriangleStart[chunk.faceSizes.size()] = chunk.triangleSmoothing.size();
+        }
+
+        double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(
+                    std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        // Element counts of a streamed file so far, for resolving and range checking indices.
+        struct StreamCounts {
+            size_t positions = 0;
+            size_t normals = 0;
+            size_t texcoords = 0;
+        };
+
+        // Parses one index field of a streamed face corner. Zero texcoord / normal indices mean
+        // "missing", like in parse(); anything else must refer to an element already read.
+        int resolveStreamIndex(int idx, size_t count, bool allowZero) {
+            if (idx == 0) {
+                if (!allowZero) throw std::runtime_error("failed to parse 'f' line (zero vertex index)");
+                return -1;
+            }
+            long long resolved = idx > 0 ? idx - 1 : static_cast<long long>(count) + idx;
+            if (resolved < 0 || resolved >= static_cast<long long>(count)) {
+                throw std::runtime_error("face index out of range (streaming needs elements before the faces using them)");
+            }
+            return static_cast<int>(resolved);
+        }
+
+        void streamLine(const char *p, const char *end, StreamCounts &counts, std::vector<tinyobj::index_t> &corners,
+                        LveObjParser::StreamVisitor &visitor) {
+            p = skipSpace(p, end);
+            if (p == end || *p == '#') return;
+
+            size_t length = static_cast<size_t>(end - p);
+            auto startsWith = [&](const char *keyword, size_t n) {
+                return length > n && std::memcmp(p, keyword, n) == 0 && isSpace(p[n]);
+            };
+
+            if (startsWith("v", 1)) {
+                p += 2;
+                float xyz[3] = {0.0f, 0.0f, 0.0f};
+                for (float &value : xyz) parseFloat(p, end, value);
+                float rgb[3] = {1.0f, 1.0f, 1.0f};
+                bool hasColor = parseFloat(p, end, rgb[0]) && parseFloat(p, end, rgb[1]) && parseFloat(p, end, rgb[2]);
+                visitor.position(xyz[0], xyz[1], xyz[2], hasColor ? rgb : nullptr);
+                counts.positions++;
+            } else if (startsWith("vn", 2)) {
+                p += 3;
+                float xyz[3] = {0.0f, 0.0f, 0.0f};
+                for (float &value : xyz) parseFloat(p, end, value);
+                visitor.normal(xyz[0], xyz[1], xyz[2]);
+                counts.normals++;
+            } else if (startsWith("vt", 2)) {
+                p += 3;
+                float uv[2] = {0.0f, 0.0f};
+                for (float &value : uv) parseFloat(p, end, value);
+                visitor.texcoord(uv[0], uv[1]);
+                counts.texcoords++;
+            } else if (startsWith("f", 1)) {
+                corners.clear();
+                p = skipSpace(p + 2, end);
+                while (p < end && *p != '\r') {
+                    tinyobj::index_t corner{-1, -1, -1};
+                    corner.vertex_index = resolveStreamIndex(parseInt(p, end), counts.positions, false);
+                    p = skipIndexField(p, end);
+                    if (p < end && *p == '/') {
+                        p++;
+                        if (p < end && *p != '/') {
+                            corner.texcoord_index = resolveStreamIndex(parseInt(p, end), counts.texcoords, true);
+                            p = skipIndexField(p, end);
+                        }
+                        if (p < end && *p == '/') {
+                            p++;
+                            corner.normal_index = resolveStreamIndex(parseInt(p, end), counts.normals, true);
+                            p = skipIndexField(p, end);
+                        }
+                    }
+                    corners.push_back(corner);
+                    p = skipSpace(p, end);
+                }
+                visitor.face(corners.data(), corners.size());
+            }
+            // Groups, materials, smoothing and the rest don't matter for a single streamed mesh.
+        }
+
+    }  // namespace
+
+    LveObjParser::LveObjParser(unsigned int threadCount, ReadMode readMode)
+            : threadCount{threadCount}, readMode{readMode} {
+        if (this->threadCount == 0) {
+            this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    std::vector<std::string> LveObjParser::splitMtlLibNames(const std::string &text) {
+        // Space separated, with '\' escaping the next character (same rules as tinyobj).
+        std::vector<std::string> names;
+        std::string name;
+        bool escaping = false;
+        for (char c : text) {
+            if (escaping) {
+                escaping = false;
+            } else if (c == '\\') {
+                escaping = true;
+                continue;
+            } else if (c == ' ') {
+                if (!name.empty()) names.push_back(name);
+                name.clear();
+                continue;
+            }
+            name += c;
+        }
+        names.push_back(name);
+        return names;
+    }
+
+    void LveObjParser::parse(const std::string &filepath, const std::string &mtlBaseDir) {
+        attrib = {};
+        shapes.clear();
+        materials.clear();
+        warn.clear();
+        stats = {};
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        // Either map the file and tokenize the page cache directly, or copy it into a buffer.
+        std::unique_ptr<LveMappedFile> mappedFile;
+        std::vector<char> buffer;
+        const char *data = nullptr;
+        size_t fileSize = 0;
+        if (readMode == ReadMode::MemoryMap) {
+            mappedFile = std::make_unique<LveMappedFile>(filepath);
+            data = mappedFile->data();
+            fileSize = mappedFile->size();
+        } else {
+            std::ifstream file{filepath, std::ios::binary | std::ios::ate};
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + filepath);
+            }
+            fileSize = static_cast<size_t>(file.tellg());
+            buffer.resize(fileSize);
+            file.seekg(0);
+            file.read(buffer.data(), static_cast<std::streamsize>(fileSize));
+            if (!file) {
+                throw std::runtime_error("failed to read file: " + filepath);
+            }
+            data = buffer.data();
+        }
+
+        stats.bytes = fileSize;
+        stats.readMs = millisecondsSince(startTime);
+
+        // Split at line boundaries. Each chunk starts right after a '\n'.
+        size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, fileSize / MIN_CHUNK_BYTES));
+        std::vector<Chunk> chunks(chunkCount);
+        const char *dataEnd = data + fileSize;
+        const char *chunkBegin = data;
+        for (size_t i = 0; i < chunkCount; i++) {
+            const char *chunkEnd = dataEnd;
+            if (i + 1 < chunkCount) {
+                const char *target = std::max(chunkBegin, data + fileSize * (i + 1) / chunkCount);
+                const char *newline = findNewline(target, dataEnd);
+                chunkEnd = newline < dataEnd ? newline + 1 : dataEnd;
+            }
+            chunks[i].begin = chunkBegin;
+            chunks[i].end = chunkEnd;
+            chunkBegin = chunkEnd;
+        }
+        stats.threads = static_cast<uint32_t>(chunkCount);
+
+        auto parseStart = std::chrono::high_resolution_clock::now();
+        forEachChunk(chunks, parseChunk);
+        throwOnChunkError(chunks, filepath);
+        stats.parseMs = millisecondsSince(parseStart);
+
+        auto mergeStart = std::chrono::high_resolution_clock::now();
+
+        // Prefix sums give every chunk the global position of its first element.
+        size_t positionCount = 0, normalCount = 0, texcoordCount = 0;
+        std::vector<uint32_t> inheritedSmoothing(chunkCount, 0);
+        uint32_t smoothing = 0;
+        for (size_t i = 0; i < chunkCount; i++) {
+            auto &chunk = chunks[i];
+            chunk.positionBase = positionCount;
+            chunk.normalBase = normalCount;
+            chunk.texcoordBase = texcoordCount;
+            positionCount += chunk.positions.size() / 3;
+            normalCount += chunk.normals.size() / 3;
+            texcoordCount += chunk.texcoords.size() / 2;
+            inheritedSmoothing[i] = smoothing;
+            if (chunk.smoothing != INHERIT_SMOOTHING) smoothing = chunk.smoothing;
+        }
+        attrib.vertices.resize(3 * positionCount);
+        attrib.colors.resize(3 * positionCount);
+        attrib.normals.resize(3 * normalCount);
+        attrib.texcoords.resize(2 * texcoordCount);
+
+        forEachChunk(chunks, [&](Chunk &chunk) {
+            rebaseChunk(chunk, attrib, inheritedSmoothing[&chunk - chunks.data()]);
+        });
+        throwOnChunkError(chunks, filepath);
+
+        forEachChunk(chunks, [&](Chunk &chunk) {
+            triangulateChunk(chunk, attrib.vertices);
+        });
+        throwOnChunkError(chunks, filepath);
+
+        // Walk the group/object/material statements in file order. This decides which shape
+        // and material every run of triangles belongs to; the copying happens afterwards.
+        struct ShapeLayout {
+            std::string name;
+            size_t triangles = 0;
+        };
+        std::vector<ShapeLayout> layouts(1);
+        std::map<std::string, int> materialMap;
+        std::set<std::string> loadedMaterialFiles;
+        tinyobj::MaterialFileReader materialReader{mtlBaseDir};
+        int materialId = -1;
+
+        for (auto &chunk : chunks) {
+            size_t face = 0;
+            auto addFaces = [&](size_t lastFace) {
+                size_t first = chunk.faceTriangleStart[face];
+                size_t count = chunk.faceTriangleStart[lastFace] - first;
+                face = lastFace;
+                if (count == 0) return;
+                chunk.segments.push_back({layouts.size() - 1, layouts.back().triangles, first, count, materialId});
+                layouts.back().triangles += count;
+            };
+
+            for (const auto &statement : chunk.statements) {
+                addFaces(statement.face);
+                switch (statement.kind) {
+                    case Statement::Group:
+                    case Statement::Object:
+                        if (layouts.back().triangles > 0) layouts.emplace_back();
+                        layouts.back().name = statement.text;
+                        break;
+                    case Statement::UseMtl: {
+                        auto it = materialMap.find(statement.text);
+                        if (it == materialMap.end()) {
+                            warn += "material [ '" + statement.text + "' ] not found in .mtl\n";
+                            materialId = -1;
+                        } else {
+                            materialId = it->second;
+                        }
+                        break;
+                    }
+                    case Statement::MtlLib: {
+                        bool found = false;
+                        for (const auto &name : splitMtlLibNames(statement.text)) {
+                            if (loadedMaterialFiles.count(name) > 0) {
+                                found = true;
+                                continue;
+                            }
+                            std::string mtlWarn, mtlErr;
+                            bool ok = materialReader(name, &materials, &materialMap, &mtlWarn, &mtlErr);
+                            warn += mtlWarn + mtlErr;
+                            if (ok) {
+                                found = true;
+                                loadedMaterialFiles.insert(name);
+                                break;
+                            }
+                        }
+                        if (!found) {
+                            warn += "Failed to load material file(s). Use default material.\n";
+                        }
+                        break;
+                    }
+                }
+            }
+            addFaces(chunk.faceSizes.size());
+        }
+        if (layouts.back().triangles == 0) layouts.pop_back();
+
+        shapes.resize(layouts.size());
+        for (size_t i = 0; i < layouts.size(); i++) {
+            auto &mesh = shapes[i].mesh;
+            shapes[i].name = layouts[i].name;
+            mesh.indices.resize(3 * layouts[i].triangles);
+            mesh.num_face_vertices.resize(layouts[i].triangles);
+            mesh.material_ids.resize(layouts[i].triangles);
+            mesh.smoothing_group_ids.resize(layouts[i].triangles);
+        }
+
+        forEachChunk(chunks, [&](Chunk &chunk) {
+            for (const auto &segment : chunk.segments) {
+                auto &mesh = shapes[segment.shape].mesh;
+                std::copy_n(chunk.triangles.begin() + 3 * segment.firstTriangle, 3 * segment.triangleCount,
+                            mesh.indices.begin() + 3 * segment.dstTriangle);
+                std::copy_n(chunk.triangleSmoothing.begin() + segment.firstTriangle, segment.triangleCount,
+                            mesh.smoothing_group_ids.begin() + segment.dstTriangle);
+                std::fill_n(mesh.num_face_vertices.begin() + segment.dstTriangle, segment.triangleCount, 3);
+                std::fill_n(mesh.material_ids.begin() + segment.dstTriangle, segment.triangleCount, segment.materialId);
+            }
+        });
+
+        uint32_t zeroIndices = 0, degenerateFaces = 0, polygons = 0, skippedElements = 0, emptyGroupNames = 0;
+        for (const auto &chunk : chunks) {
+            zeroIndices += chunk.zeroIndices;
+            degenerateFaces += chunk.degenerateFaces;
+            polygons += chunk.polygons;
+            skippedElements += chunk.skippedElements;
+            emptyGroupNames += chunk.emptyGroupNames;
+        }
+        if (zeroIndices) warn += std::to_string(zeroIndices) + " zero texcoord/normal indices treated as missing\n";
+        if (degenerateFaces) warn += std::to_string(degenerateFaces) + " degenerate faces skipped\n";
+        if (polygons) warn += std::to_string(polygons) + " faces with more than 4 vertices fan triangulated\n";
+        if (skippedElements) warn += std::to_string(skippedElements) + " line/point elements ignored\n";
+        if (emptyGroupNames) warn += std::to_string(emptyGroupNames) + " empty group names\n";
+
+        stats.mergeMs = millisecondsSince(mergeStart);
+    }
+
+    void LveObjParser::stream(const std::string &filepath, size_t windowBytes, StreamVisitor &visitor) {
+        stats = {};
+        stats.threads = 1;
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        std::ifstream file{filepath, std::ios::binary};
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open file: " + filepath);
+        }
+
+        std::vector<char> window(windowBytes);
+        std::vector<tinyobj::index_t> corners;
+        StreamCounts counts;
+        size_t filled = 0;
+        size_t lineNumber = 0;
+        bool endOfFile = false;
+        while (true) {
+            if (!endOfFile) {
+                file.read(window.data() + filled, static_cast<std::streamsize>(windowBytes - filled));
+                auto got = static_cast<size_t>(file.gcount());
+                filled += got;
+                stats.bytes += got;
+                endOfFile = !file;
+            }
+
+            // Every complete line of the window; the last line stays for the next read unless
+            // the file has ended.
+            const char *p = window.data();
+            const char *end = p + filled;
+            while (p < end) {
+                const char *lineEnd = findNewline(p, end);
+                if (lineEnd == end && !endOfFile) break;
+                const char *contentEnd = lineEnd;
+                if (contentEnd > p && contentEnd[-1] == '\r') contentEnd--;
+
+                lineNumber++;
+                try {
+                    streamLine(p, contentEnd, counts, corners, visitor);
+                } catch (const std::exception &e) {
+                    throw std::runtime_error(filepath + ": " + e.what() + " (line " + std::to_string(lineNumber) + ")");
+                }
+                p = lineEnd < end ? lineEnd + 1 : end;
+            }
+
+            auto consumed = static_cast<size_t>(p - window.data());
+            if (consumed == 0 && filled == windowBytes) {
+                throw std::runtime_error(filepath + ": line " + std::to_string(lineNumber + 1) +
+                                         " is longer than the streaming window");
+            }
+            std::memmove(window.data(), p, filled - consumed);
+            filled -= consumed;
+            if (endOfFile && filled == 0) break;
+        }
+        stats.parseMs = millisecondsSince(startTime);
+    }
+
+}  // namespace lve
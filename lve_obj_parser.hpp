@@ -0,0 +1,82 @@
+#ifndef VULKANTEST_LVE_OBJ_PARSER_HPP
+#define VULKANTEST_LVE_OBJ_PARSER_HPP
+
+#include <tiny_obj_loader.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Multithreaded replacement for tinyobj::LoadObj.
+     *
+     * The file is split into chunks at line boundaries and every chunk is tokenized on its own
+     * thread into private buffers. The chunks are then merged in file order, so the result does
+     * not depend on the thread count. Relative (negative) indices are resolved against the
+     * running element counts of the preceding chunks.
+     *
+     * The output uses the same attrib_t / shape_t layout tinyobj produces with triangulation and
+     * default vertex colors enabled. Triangles and quads come out identical (quads are split
+     * along the shorter diagonal, like tinyobj does). Faces with more than four corners are fan
+     * triangulated instead of ear clipped, and 'l'/'p' elements are skipped. Out of range
+     * indices are an error here rather than a warning.
+     */
+    class LveObjParser {
+    public:
+        struct Stats {
+            uint32_t threads = 0;
+            uint64_t bytes = 0;
+            double readMs = 0.0;   // file copy, or just the mapping in MemoryMap mode
+            double parseMs = 0.0;  // per chunk tokenizing, runs in parallel
+            double mergeMs = 0.0;  // index resolution, triangulation and shape assembly
+        };
+
+        enum class ReadMode {
+            Stream,     // copy the file into a heap buffer with std::ifstream
+            MemoryMap,  // tokenize a read-only mapping of the file, no copy
+        };
+
+        // Receives the elements of a file read by stream(), in file order. Face indices are
+        // resolved and zero based, -1 where a corner has no texcoord / normal.
+        class StreamVisitor {
+        public:
+            virtual ~StreamVisitor() = default;
+            // color is nullptr if the line has no vertex color.
+            virtual void position(float /*x*/, float /*y*/, float /*z*/, const float * /*color*/) {}
+            virtual void normal(float /*x*/, float /*y*/, float /*z*/) {}
+            virtual void texcoord(float /*u*/, float /*v*/) {}
+            virtual void face(const tinyobj::index_t * /*corners*/, size_t /*cornerCount*/) {}
+        };
+
+        // threadCount 0 uses one thread per hardware core.
+        explicit LveObjParser(unsigned int threadCount = 0, ReadMode readMode = ReadMode::MemoryMap);
+
+        // Throws std::runtime_error if the file cannot be read or is malformed.
+        void parse(const std::string &filepath, const std::string &mtlBaseDir = "");
+
+        // Single threaded alternative to parse() for files too big to hold in memory: reads the
+        // file through one buffer of windowBytes and hands its 'v', 'vn', 'vt' and 'f' lines to
+        // visitor instead of building attrib / shapes. Faces may only reference elements defined
+        // before them. Only stats.bytes and stats.parseMs are filled in.
+        void stream(const std::string &filepath, size_t windowBytes, StreamVisitor &visitor);
+
+        // The file names of an 'mtllib' line (the text after the keyword), in the order tinyobj
+        // tries them.
+        static std::vector<std::string> splitMtlLibNames(const std::string &text);
+
+        tinyobj::attrib_t attrib{};
+        std::vector<tinyobj::shape_t> shapes{};
+        std::vector<tinyobj::material_t> materials{};
+        std::string warn{};
+        Stats stats{};
+
+    private:
+        unsigned int threadCount;
+        ReadMode readMode;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_OBJ_PARSER_HPP
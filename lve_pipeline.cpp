@@ -17,9 +17,9 @@ namespace lve {
     }
 
     LvePipeline::~LvePipeline() {
-        vkDestroyShaderModule(lveDevice.device(), fragShaderModule, nullptr);
-        vkDestroyShaderModule(lveDevice.device(), vertShaderModule, nullptr);
-        vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
+        vkDestroyShaderModule(lveDevice.device(), fragShaderModule, lveDevice.allocationCallbacks());
+        vkDestroyShaderModule(lveDevice.device(), vertShaderModule, lveDevice.allocationCallbacks());
+        vkDestroyPipeline(lveDevice.device(), graphicsPipeline, lveDevice.allocationCallbacks());
     }
 
     std::vector<char> LvePipeline::readFile(const std::string &filename)
@@ -94,7 +94,7 @@ namespace lve {
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
         pipelineInfo.basePipelineIndex = -1;
 
-        if (vkCreateGraphicsPipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(lveDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, lveDevice.allocationCallbacks(), &graphicsPipeline) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline!");
         }
 
@@ -106,7 +106,7 @@ namespace lve {
         createInfo.codeSize = code.size();
         createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
 
-        if (vkCreateShaderModule(lveDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
+        if (vkCreateShaderModule(lveDevice.device(), &createInfo, lveDevice.allocationCallbacks(), shaderModule) != VK_SUCCESS) {
             throw std::runtime_error("failed to create shader module!");
         }
     }
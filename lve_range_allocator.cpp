@@ -0,0 +1,91 @@
+#include "lve_range_allocator.hpp"
+
+// std
+#include <cassert>
+#include <iterator>
+
+namespace lve {
+
+    LveRangeAllocator::LveRangeAllocator(uint64_t capacity) : capacity{capacity} {
+        if (capacity > 0) freeRanges.emplace(0, capacity);
+    }
+
+    uint64_t LveRangeAllocator::allocate(uint64_t size, uint64_t alignment) {
+        if (size == 0 || alignment == 0) return INVALID_OFFSET;
+
+        auto best = freeRanges.end();
+        uint64_t bestOffset = 0;
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+            uint64_t aligned = (it->first + alignment - 1) / alignment * alignment;
+            uint64_t padding = aligned - it->first;
+            if (padding > it->second || it->second - padding < size) continue;
+            if (best == freeRanges.end() || it->second < best->second) {
+                best = it;
+                bestOffset = aligned;
+                if (it->second - padding == size) break;  // exact fit
+            }
+        }
+        if (best == freeRanges.end()) return INVALID_OFFSET;
+        return take(best, bestOffset, size);
+    }
+
+    uint64_t LveRangeAllocator::allocateBelow(uint64_t size, uint64_t alignment, uint64_t limit) {
+        if (size == 0 || alignment == 0) return INVALID_OFFSET;
+
+        for (auto it = freeRanges.begin(); it != freeRanges.end() && it->first < limit; ++it) {
+            uint64_t aligned = (it->first + alignment - 1) / alignment * alignment;
+            uint64_t padding = aligned - it->first;
+            if (aligned >= limit || padding > it->second || it->second - padding < size) continue;
+            return take(it, aligned, size);
+        }
+        return INVALID_OFFSET;
+    }
+
+    uint64_t LveRangeAllocator::take(std::map<uint64_t, uint64_t>::iterator range, uint64_t offset, uint64_t size) {
+        // Split the range into the alignment padding, the allocation and the tail.
+        uint64_t rangeOffset = range->first;
+        uint64_t rangeEnd = range->first + range->second;
+        freeRanges.erase(range);
+        if (offset > rangeOffset) freeRanges.emplace(rangeOffset, offset - rangeOffset);
+        if (offset + size < rangeEnd) freeRanges.emplace(offset + size, rangeEnd - offset - size);
+
+        allocations++;
+        return offset;
+    }
+
+    void LveRangeAllocator::free(uint64_t offset, uint64_t size) {
+        if (size == 0) return;
+        assert(offset + size <= capacity && "Freed range is outside the allocator");
+
+        auto next = freeRanges.lower_bound(offset);
+        assert((next == freeRanges.end() || offset + size <= next->first) && "Freed range overlaps free space");
+        if (next != freeRanges.end() && next->first == offset + size) {
+            size += next->second;
+            next = freeRanges.erase(next);
+        }
+        if (next != freeRanges.begin()) {
+            auto previous = std::prev(next);
+            assert(previous->first + previous->second <= offset && "Freed range overlaps free space");
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                size = 0;
+            }
+        }
+        if (size > 0) freeRanges.emplace(offset, size);
+        allocations--;
+    }
+
+    LveRangeAllocator::Stats LveRangeAllocator::getStats() const {
+        Stats stats{};
+        stats.capacity = capacity;
+        stats.allocations = allocations;
+        stats.freeRanges = static_cast<uint32_t>(freeRanges.size());
+        for (const auto &range : freeRanges) {
+            stats.freeBytes += range.second;
+            if (range.second > stats.largestFreeRange) stats.largestFreeRange = range.second;
+        }
+        stats.usedBytes = capacity - stats.freeBytes;
+        return stats;
+    }
+
+}  // namespace lve
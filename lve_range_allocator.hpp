@@ -0,0 +1,55 @@
+#ifndef VULKANTEST_LVE_RANGE_ALLOCATOR_HPP
+#define VULKANTEST_LVE_RANGE_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <map>
+
+namespace lve {
+
+    /**
+     * Hands out [offset, offset + size) ranges of a fixed size address space, e.g. a buffer.
+     *
+     * Free space is kept as a map of ranges by offset; allocation takes the smallest free range
+     * that fits (best fit), freeing merges a range with its free neighbours. Alignments don't
+     * need to be powers of two, so vertex ranges can be aligned to their stride.
+     */
+    class LveRangeAllocator {
+    public:
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        struct Stats {
+            uint64_t capacity = 0;
+            uint64_t usedBytes = 0;
+            uint64_t freeBytes = 0;
+            uint64_t largestFreeRange = 0;
+            uint32_t freeRanges = 0;
+            uint32_t allocations = 0;
+            // 0 when all free space is one range, towards 1 the more it is scattered.
+            float fragmentation() const {
+                return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes);
+            }
+        };
+
+        explicit LveRangeAllocator(uint64_t capacity);
+
+        // Returns INVALID_OFFSET if no free range fits.
+        uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+        // Takes the lowest free range that fits and starts below limit (first fit), for moving an
+        // allocation towards the start. Returns INVALID_OFFSET if there is none.
+        uint64_t allocateBelow(uint64_t size, uint64_t alignment, uint64_t limit);
+        void free(uint64_t offset, uint64_t size);
+
+        Stats getStats() const;
+        uint64_t getCapacity() const { return capacity; }
+
+    private:
+        uint64_t take(std::map<uint64_t, uint64_t>::iterator range, uint64_t offset, uint64_t size);
+
+        uint64_t capacity;
+        uint32_t allocations = 0;
+        std::map<uint64_t, uint64_t> freeRanges;  // offset -> size
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_RANGE_ALLOCATOR_HPP
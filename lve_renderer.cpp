@@ -26,8 +26,6 @@ namespace lve {
             glfwWaitEvents();
         }
 
-        vkDeviceWaitIdle(lveDevice.device());
-
         if (lveSwapChain == nullptr) {
             lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
         } else {
@@ -38,6 +36,9 @@ namespace lve {
                 throw std::runtime_error("Swap chain image(or depth) format has changed!");
             }
 
+            // Frames in flight may still render to the old images and framebuffers.
+            lveDevice.deletionQueue().defer([oldSwapChain]() mutable { oldSwapChain.reset(); });
+
         }
     }
 
@@ -80,6 +81,12 @@ namespace lve {
             throw std::runtime_error("failed to acquire swap chain image!");
         }
 
+        // acquireNextImage waited for the fence of the frame that used this frame slot last,
+        // and so for every frame submitted before it.
+        auto &deletionQueue = lveDevice.deletionQueue();
+        uint64_t frame = deletionQueue.currentFrame();
+        if (frame > LveSwapChain::MAX_FRAMES_IN_FLIGHT) deletionQueue.collect(frame - LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+
         isFrameStarted = true;
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
@@ -99,6 +106,7 @@ namespace lve {
         }
 
         auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+        lveDevice.deletionQueue().frameSubmitted();
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()) {
             lveWindow.resetWindowResizedFlag();
             recreateSwapChain();
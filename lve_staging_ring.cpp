@@ -0,0 +1,85 @@
+#include "lve_staging_ring.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+    LveStagingRing::LveStagingRing(LveDevice &device, VkDeviceSize size)
+            : capacity{(size + 255) / 256 * 256} {
+        buffer = std::make_unique<LveBuffer>(
+                device,
+                capacity,
+                1,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (buffer->map() != VK_SUCCESS) {
+            throw std::runtime_error("failed to map staging ring!");
+        }
+        stats.capacity = capacity;
+    }
+
+    LveStagingRing::~LveStagingRing() {
+        // Dropping the tokens waits for the copies still reading from the ring.
+        entries.clear();
+    }
+
+    void LveStagingRing::reclaim() {
+        while (!entries.empty() && entries.front().token && entries.front().token->isComplete()) {
+            tail = entries.front().end;
+            entries.pop_front();
+        }
+        if (entries.empty()) head = tail = 0;
+    }
+
+    LveStagingRing::Region LveStagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+        assert(size > 0 && size <= getMaxRegion() && "Staging region larger than the ring hands out");
+        std::unique_lock<std::mutex> lock{mutex};
+        for (;;) {
+            reclaim();
+            uint64_t position = (head + alignment - 1) / alignment * alignment;
+            // Regions don't wrap around the end of the buffer.
+            if (position % capacity + size > capacity) position += capacity - position % capacity;
+            if (position + size - tail <= capacity) {
+                Region region{buffer->getBuffer(), position % capacity, size, nullptr, nextId++};
+                region.mapped = static_cast<char *>(buffer->getMappedMemory()) + region.offset;
+                entries.push_back({region.id, position + size, nullptr});
+                head = position + size;
+                stats.bytesStaged += size;
+                stats.regions++;
+                stats.peakBytesInUse = std::max<VkDeviceSize>(stats.peakBytesInUse, head - tail);
+                return region;
+            }
+
+            // Full: wait for the oldest upload, unless nobody has submitted it yet.
+            if (!entries.front().token) {
+                stats.fullRefusals++;
+                return {};
+            }
+            auto oldest = entries.front().token;
+            stats.fenceWaits++;
+            lock.unlock();
+            oldest->wait();
+            lock.lock();
+        }
+    }
+
+    void LveStagingRing::release(const std::vector<uint64_t> &regions,
+                                 const std::shared_ptr<LveUploadBatch::Token> &token) {
+        std::lock_guard<std::mutex> lock{mutex};
+        for (uint64_t id : regions) {
+            auto entry = std::lower_bound(entries.begin(), entries.end(), id,
+                                          [](const Entry &entry, uint64_t id) { return entry.id < id; });
+            assert(entry != entries.end() && entry->id == id && "Released an unknown staging region");
+            entry->token = token;
+        }
+    }
+
+    LveStagingRing::Stats LveStagingRing::getStats() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return stats;
+    }
+
+}  // namespace lve
@@ -0,0 +1,89 @@
+#ifndef VULKANTEST_LVE_STAGING_RING_HPP
+#define VULKANTEST_LVE_STAGING_RING_HPP
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+#include "lve_upload_batch.hpp"
+
+// std
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * One persistently mapped staging buffer that uploads take their source memory from, instead
+     * of creating and freeing a host visible buffer per upload.
+     *
+     * Regions are handed out in order around the ring. A region is given back when the upload
+     * batch that copies from it submits (release()), and becomes free once that submission's fence
+     * has signalled; the tail only moves past regions in allocation order. When the ring is
+     * full, allocate() waits for the oldest submission. If the oldest regions have not been
+     * submitted yet it returns an empty region instead, and the batch submits what it has
+     * recorded (see LveUploadBatch::uploadBuffer). Uploads larger than getMaxRegion() are
+     * split into several regions.
+     *
+     * Owned by LveDevice, shared by every batch; thread safe.
+     */
+    class LveStagingRing {
+    public:
+        static constexpr VkDeviceSize DEFAULT_SIZE = 32ull * 1024 * 1024;
+
+        struct Region {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;  // 0 when the ring had no space
+            void *mapped = nullptr;
+            uint64_t id = 0;
+        };
+
+        struct Stats {
+            VkDeviceSize capacity = 0;
+            uint64_t bytesStaged = 0;
+            uint64_t regions = 0;
+            VkDeviceSize peakBytesInUse = 0;
+            uint32_t fenceWaits = 0;  // allocations that had to wait for an upload to finish
+            uint32_t fullRefusals = 0;  // allocations refused because unsubmitted regions filled the ring
+        };
+
+        LveStagingRing(LveDevice &device, VkDeviceSize size = DEFAULT_SIZE);
+        ~LveStagingRing();
+
+        LveStagingRing(const LveStagingRing &) = delete;
+        LveStagingRing &operator=(const LveStagingRing &) = delete;
+
+        // The largest region allocate() hands out, so a few uploads can be in flight at once.
+        VkDeviceSize getMaxRegion() const { return capacity / 4; }
+        // size must not exceed getMaxRegion().
+        Region allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+        // The regions are read by the submission behind token and can be reused after it.
+        void release(const std::vector<uint64_t> &regions, const std::shared_ptr<LveUploadBatch::Token> &token);
+
+        Stats getStats() const;
+
+    private:
+        struct Entry {
+            uint64_t id;
+            uint64_t end;  // ring position after the region
+            std::shared_ptr<LveUploadBatch::Token> token;  // null until released
+        };
+
+        void reclaim();
+
+        VkDeviceSize capacity;
+        std::unique_ptr<LveBuffer> buffer;
+
+        mutable std::mutex mutex;
+        std::deque<Entry> entries;  // in allocation order
+        uint64_t head = 0;  // ring positions grow without wrapping; the offset is position % capacity
+        uint64_t tail = 0;
+        uint64_t nextId = 1;
+        Stats stats{};
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_STAGING_RING_HPP
@@ -0,0 +1,339 @@
+#include "lve_streaming_loader.hpp"
+#include "lve_obj_parser.hpp"
+#include "lve_upload_batch.hpp"
+
+#include <sys/resource.h>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+    namespace {
+
+        constexpr uint32_t NO_VERTEX = UINT32_MAX;
+
+        // Counts the bytes of every buffer the loader owns and refuses to go over the cap.
+        class MemoryBudget {
+        public:
+            explicit MemoryBudget(uint64_t cap) : cap{cap} {}
+
+            void add(uint64_t bytes) {
+                if (bytes > cap - used) throw exceeded();
+                used += bytes;
+                peak = std::max(peak, used);
+            }
+
+            // Call before every push_back. Grows like std::vector would but never past the cap;
+            // the old storage is still alive while the new one is allocated, so both count.
+            template <typename T>
+            void reserveOneMore(std::vector<T> &vector) {
+                if (vector.size() < vector.capacity()) return;
+                size_t wanted = std::max<size_t>(1024, vector.capacity() * 2);
+                size_t affordable = static_cast<size_t>((cap - used) / sizeof(T));
+                size_t capacity = std::min(wanted, affordable);
+                if (capacity <= vector.size()) throw exceeded();
+
+                uint64_t oldBytes = vector.capacity() * sizeof(T);
+                peak = std::max(peak, used + capacity * sizeof(T));
+                vector.reserve(capacity);
+                used = used - oldBytes + vector.capacity() * sizeof(T);
+            }
+
+            uint64_t getPeak() const { return peak; }
+
+        private:
+            std::runtime_error exceeded() const {
+                return std::runtime_error("streaming load needs more than its memory cap of " +
+                                          std::to_string(cap / (1024 * 1024)) + " MiB");
+            }
+
+            uint64_t cap;
+            uint64_t used = 0;
+            uint64_t peak = 0;
+        };
+
+        // Appends data to a device local buffer through a persistently mapped staging buffer. One
+        // half is copied while the other fills; a half is only reused once its copy completed.
+        class StagingWriter {
+        public:
+            StagingWriter(LveDevice &device, VkDeviceSize stagingBytes) : batch{device} {
+                staging = std::make_unique<LveBuffer>(
+                        device,
+                        1,
+                        static_cast<uint32_t>(stagingBytes),
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                staging->map();
+                halfBytes = stagingBytes / 2;
+            }
+
+            ~StagingWriter() {
+                for (auto &token : tokens) {
+                    if (token) token->wait();
+                }
+            }
+
+            void begin(VkBuffer buffer) {
+                flush();
+                destination = buffer;
+                destinationOffset = 0;
+            }
+
+            void write(const void *data, size_t size) {
+                if (used + size > halfBytes) flush();
+                auto *mapped = static_cast<char *>(staging->getMappedMemory());
+                std::memcpy(mapped + half * halfBytes + used, data, size);
+                used += size;
+            }
+
+            void flush() {
+                if (used == 0) return;
+                batch.copyBuffer(staging->getBuffer(), destination, used, destinationOffset, half * halfBytes);
+                tokens[half] = batch.submit();
+                destinationOffset += used;
+                used = 0;
+                flushes++;
+
+                half ^= 1;
+                if (tokens[half]) {
+                    tokens[half]->wait();
+                    tokens[half].reset();
+                }
+            }
+
+            uint32_t getFlushes() const { return flushes; }
+
+        private:
+            LveUploadBatch batch;
+            std::unique_ptr<LveBuffer> staging;
+            std::shared_ptr<LveUploadBatch::Token> tokens[2];
+            VkDeviceSize halfBytes = 0;
+            uint32_t half = 0;
+            VkDeviceSize used = 0;
+
+            VkBuffer destination = VK_NULL_HANDLE;
+            VkDeviceSize destinationOffset = 0;
+            uint32_t flushes = 0;
+        };
+
+        // One output vertex: the index triple the faces use, chained per position.
+        struct VertexKey {
+            int32_t position;
+            int32_t texcoord;
+            int32_t normal;
+            uint32_t next;  // next vertex sharing the position, NO_VERTEX at the end
+        };
+
+        // First pass: attributes, the distinct vertices and the triangle count.
+        class AttributePass : public LveObjParser::StreamVisitor {
+        public:
+            explicit AttributePass(MemoryBudget &budget) : budget{budget} {}
+
+            void position(float x, float y, float z, const float *color) override {
+                budget.reserveOneMore(positions);
+                positions.push_back({x, y, z});
+                budget.reserveOneMore(firstVertex);
+                firstVertex.push_back(NO_VERTEX);
+
+                // Most scans have no vertex colors; only store them once one shows up.
+                if (color != nullptr && colors.empty()) {
+                    while (colors.size() + 1 < positions.size()) {
+                        budget.reserveOneMore(colors);
+                        colors.push_back(glm::vec3{1.f});
+                    }
+                }
+                if (!colors.empty() || color != nullptr) {
+                    budget.reserveOneMore(colors);
+                    colors.push_back(color ? glm::vec3{color[0], color[1], color[2]} : glm::vec3{1.f});
+                }
+            }
+
+            void normal(float x, float y, float z) override {
+                budget.reserveOneMore(normals);
+                normals.push_back({x, y, z});
+            }
+
+            void texcoord(float u, float v) override {
+                budget.reserveOneMore(texcoords);
+                texcoords.push_back({u, v});
+            }
+
+            void face(const tinyobj::index_t *corners, size_t cornerCount) override {
+                if (cornerCount < 3) return;
+                for (size_t i = 0; i < cornerCount; i++) {
+                    findOrAdd(corners[i]);
+                }
+                triangles += cornerCount - 2;
+            }
+
+            uint32_t find(const tinyobj::index_t &corner) const {
+                for (uint32_t vertex = firstVertex[corner.vertex_index]; vertex != NO_VERTEX; vertex = vertices[vertex].next) {
+                    if (vertices[vertex].texcoord == corner.texcoord_index && vertices[vertex].normal == corner.normal_index) {
+                        return vertex;
+                    }
+                }
+                return NO_VERTEX;
+            }
+
+            LveModel::Vertex makeVertex(uint32_t vertex) const {
+                const VertexKey &key = vertices[vertex];
+                LveModel::Vertex result{};
+                result.position = positions[key.position];
+                result.color = colors.empty() ? glm::vec3{1.f} : colors[key.position];
+                if (key.normal >= 0) result.normal = normals[key.normal];
+                if (key.texcoord >= 0) result.uv = texcoords[key.texcoord];
+                return result;
+            }
+
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> colors;
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec2> texcoords;
+            std::vector<uint32_t> firstVertex;  // per position
+            std::vector<VertexKey> vertices;
+            uint64_t triangles = 0;
+
+        private:
+            void findOrAdd(const tinyobj::index_t &corner) {
+                if (find(corner) != NO_VERTEX) return;
+                budget.reserveOneMore(vertices);
+                vertices.push_back({corner.vertex_index, corner.texcoord_index, corner.normal_index,
+                                    firstVertex[corner.vertex_index]});
+                firstVertex[corner.vertex_index] = static_cast<uint32_t>(vertices.size() - 1);
+            }
+
+            MemoryBudget &budget;
+        };
+
+        // Second pass: triangulates the faces exactly like LveObjParser and writes the indices.
+        class IndexPass : public LveObjParser::StreamVisitor {
+        public:
+            IndexPass(const AttributePass &attributes, StagingWriter &writer, bool shortIndices)
+                    : attributes{attributes}, writer{writer}, shortIndices{shortIndices} {}
+
+            void face(const tinyobj::index_t *corners, size_t cornerCount) override {
+                if (cornerCount < 3) return;
+                if (cornerCount == 4) {
+                    // Split along the shorter diagonal, like tinyobj.
+                    const auto &positions = attributes.positions;
+                    glm::vec3 e02 = positions[corners[2].vertex_index] - positions[corners[0].vertex_index];
+                    glm::vec3 e13 = positions[corners[3].vertex_index] - positions[corners[1].vertex_index];
+                    if (glm::dot(e02, e02) < glm::dot(e13, e13)) {
+                        emit(corners[0], corners[1], corners[2]);
+                        emit(corners[0], corners[2], corners[3]);
+                    } else {
+                        emit(corners[0], corners[1], corners[3]);
+                        emit(corners[1], corners[2], corners[3]);
+                    }
+                    return;
+                }
+                for (size_t i = 1; i + 1 < cornerCount; i++) {
+                    emit(corners[0], corners[i], corners[i + 1]);
+                }
+            }
+
+        private:
+            void emit(const tinyobj::index_t &a, const tinyobj::index_t &b, const tinyobj::index_t &c) {
+                for (const auto *corner : {&a, &b, &c}) {
+                    uint32_t index = attributes.find(*corner);
+                    if (shortIndices) {
+                        auto shortIndex = static_cast<uint16_t>(index);
+                        writer.write(&shortIndex, sizeof(shortIndex));
+                    } else {
+                        writer.write(&index, sizeof(index));
+                    }
+                }
+            }
+
+            const AttributePass &attributes;
+            StagingWriter &writer;
+            bool shortIndices;
+        };
+
+        double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+    }  // namespace
+
+    LveModel::GpuMesh LveStreamingLoader::load(const std::string &filepath) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        stats = {};
+        MemoryBudget budget{options.memoryCap};
+        budget.add(options.windowBytes);
+        budget.add(options.stagingBytes);
+
+        LveObjParser parser{1};
+        AttributePass attributes{budget};
+        parser.stream(filepath, options.windowBytes, attributes);
+        stats.sourceBytes = parser.stats.bytes;
+        stats.attributePassMs = parser.stats.parseMs;
+        if (attributes.triangles == 0) {
+            throw std::runtime_error(filepath + ": no faces to stream");
+        }
+
+        LveModel::GpuMesh mesh{};
+        mesh.vertexCount = static_cast<uint32_t>(attributes.vertices.size());
+        mesh.indexCount = static_cast<uint32_t>(attributes.triangles * 3);
+        bool shortIndices = mesh.vertexCount <= UINT16_MAX + 1u;
+        mesh.indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+        mesh.bounds = LveBounds::compute(attributes.positions.data(), attributes.positions.size());
+
+        mesh.vertexBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                sizeof(LveModel::Vertex),
+                mesh.vertexCount,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        mesh.indexBuffer = std::make_unique<LveBuffer>(
+                lveDevice,
+                shortIndices ? sizeof(uint16_t) : sizeof(uint32_t),
+                mesh.indexCount,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        StagingWriter writer{lveDevice, options.stagingBytes};
+        writer.begin(mesh.vertexBuffer->getBuffer());
+        for (uint32_t vertex = 0; vertex < mesh.vertexCount; vertex++) {
+            LveModel::Vertex data = attributes.makeVertex(vertex);
+            writer.write(&data, sizeof(data));
+        }
+
+        auto indexStart = std::chrono::high_resolution_clock::now();
+        writer.begin(mesh.indexBuffer->getBuffer());
+        IndexPass indexPass{attributes, writer, shortIndices};
+        parser.stream(filepath, options.windowBytes, indexPass);
+        writer.flush();
+        stats.indexPassMs = millisecondsSince(indexStart);
+        stats.stagingFlushes = writer.getFlushes();
+
+        stats.positions = static_cast<uint32_t>(attributes.positions.size());
+        stats.vertices = mesh.vertexCount;
+        stats.triangles = attributes.triangles;
+        stats.peakBytes = budget.getPeak();
+
+        // What parseObj holds at once for the same file: tinyobj's attributes, the triangulated
+        // index triples of the shapes, the dedup table and the output vertex and index lists.
+        uint64_t corners = stats.triangles * 3;
+        uint64_t dedupSlots = 16;
+        while (dedupSlots < corners + corners / 4) dedupSlots <<= 1;
+        stats.inMemoryPeakBytes = stats.positions * 2 * sizeof(glm::vec3) +
+                                  attributes.normals.size() * sizeof(glm::vec3) +
+                                  attributes.texcoords.size() * sizeof(glm::vec2) +
+                                  corners * sizeof(tinyobj::index_t) + dedupSlots * 2 * sizeof(uint32_t) +
+                                  uint64_t{mesh.vertexCount} * sizeof(LveModel::Vertex) + corners * sizeof(uint32_t);
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        stats.processPeakRssBytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+        stats.totalMs = millisecondsSince(startTime);
+        return mesh;
+    }
+
+}  // namespace lve
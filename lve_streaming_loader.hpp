@@ -0,0 +1,65 @@
+#ifndef VULKANTEST_LVE_STREAMING_LOADER_HPP
+#define VULKANTEST_LVE_STREAMING_LOADER_HPP
+
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+    /**
+     * Builds a model from an OBJ too big for LveModel::Builder, with a hard cap on memory.
+     *
+     * The file is read twice through LveObjParser::stream. The first pass keeps the vertex
+     * attributes and a table of the distinct (position, texcoord, normal) index triples the faces
+     * use; the second pass turns the faces into indices. Vertices and indices are written straight
+     * into a persistently mapped staging buffer, which is copied to the device local buffers half
+     * by half while the other half fills. Nothing else of the mesh is ever held in memory.
+     *
+     * Every allocation of the loader is counted against Options::memoryCap (including the read
+     * window and the staging buffer) and the load fails with std::runtime_error rather than go
+     * over it. Unlike the Builder, vertices are deduplicated by index triple instead of value, so
+     * repeated positions in the file stay separate vertices.
+     */
+    class LveStreamingLoader {
+    public:
+        struct Options {
+            uint64_t memoryCap = 256ull * 1024 * 1024;
+            size_t windowBytes = 4 * 1024 * 1024;          // file read buffer
+            VkDeviceSize stagingBytes = 8 * 1024 * 1024;   // mapped staging memory, used as two halves
+        };
+
+        struct Stats {
+            uint64_t sourceBytes = 0;
+            uint32_t positions = 0;
+            uint32_t vertices = 0;
+            uint64_t triangles = 0;
+            uint32_t stagingFlushes = 0;
+            uint64_t peakBytes = 0;            // the loader's own high water mark, <= memoryCap
+            uint64_t inMemoryPeakBytes = 0;    // lower bound of the Builder's peak for the same file
+            uint64_t processPeakRssBytes = 0;  // process high water mark after the load
+            double attributePassMs = 0.0;
+            double indexPassMs = 0.0;
+            double totalMs = 0.0;
+        };
+
+        LveStreamingLoader(LveDevice &device, const Options &options) : lveDevice{device}, options{options} {}
+
+        LveStreamingLoader(const LveStreamingLoader&) = delete;
+        LveStreamingLoader &operator=(const LveStreamingLoader&) = delete;
+
+        LveModel::GpuMesh load(const std::string &filepath);
+
+        const Stats &getStats() const { return stats; }
+
+    private:
+        LveDevice &lveDevice;
+        Options options;
+        Stats stats;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_STREAMING_LOADER_HPP
@@ -33,32 +33,32 @@ namespace lve {
 
     LveSwapChain::~LveSwapChain() {
         for (auto imageView: swapChainImageViews) {
-            vkDestroyImageView(device.device(), imageView, nullptr);
+            vkDestroyImageView(device.device(), imageView, device.allocationCallbacks());
         }
         swapChainImageViews.clear();
 
         if (swapChain != nullptr) {
-            vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
+            vkDestroySwapchainKHR(device.device(), swapChain, device.allocationCallbacks());
             swapChain = nullptr;
         }
 
         for (int i = 0; i < depthImages.size(); i++) {
-            vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            vkDestroyImageView(device.device(), depthImageViews[i], device.allocationCallbacks());
+            vkDestroyImage(device.device(), depthImages[i], device.allocationCallbacks());
+            device.memoryAllocator().free(depthImageMemorys[i]);
         }
 
         for (auto framebuffer: swapChainFramebuffers) {
-            vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+            vkDestroyFramebuffer(device.device(), framebuffer, device.allocationCallbacks());
         }
 
-        vkDestroyRenderPass(device.device(), renderPass, nullptr);
+        vkDestroyRenderPass(device.device(), renderPass, device.allocationCallbacks());
 
-        // cleanup synchronization objects
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-            vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-            vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+        // cleanup synchronization objects, unless the next swap chain took them over
+        for (size_t i = 0; i < inFlightFences.size(); i++) {
+            vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], device.allocationCallbacks());
+            vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], device.allocationCallbacks());
+            vkDestroyFence(device.device(), inFlightFences[i], device.allocationCallbacks());
         }
     }
 
@@ -173,7 +173,7 @@ namespace lve {
 
         createInfo.oldSwapchain = oldSwapChain == nullptr ? VK_NULL_HANDLE : oldSwapChain->swapChain;
 
-        if (vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
+        if (vkCreateSwapchainKHR(device.device(), &createInfo, device.allocationCallbacks(), &swapChain) != VK_SUCCESS) {
             throw std::runtime_error("failed to create swap chain!");
         }
 
@@ -203,7 +203,7 @@ namespace lve {
             viewInfo.subresourceRange.baseArrayLayer = 0;
             viewInfo.subresourceRange.layerCount = 1;
 
-            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &swapChainImageViews[i]) !=
+            if (vkCreateImageView(device.device(), &viewInfo, device.allocationCallbacks(), &swapChainImageViews[i]) !=
                 VK_SUCCESS) {
                 throw std::runtime_error("failed to create texture image view!");
             }
@@ -266,7 +266,7 @@ namespace lve {
         renderPassInfo.dependencyCount = 1;
         renderPassInfo.pDependencies = &dependency;
 
-        if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        if (vkCreateRenderPass(device.device(), &renderPassInfo, device.allocationCallbacks(), &renderPass) != VK_SUCCESS) {
             throw std::runtime_error("failed to create render pass!");
         }
     }
@@ -289,7 +289,7 @@ namespace lve {
             if (vkCreateFramebuffer(
                     device.device(),
                     &framebufferInfo,
-                    nullptr,
+                    device.allocationCallbacks(),
                     &swapChainFramebuffers[i]) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create framebuffer!");
             }
@@ -339,17 +339,27 @@ namespace lve {
             viewInfo.subresourceRange.baseArrayLayer = 0;
             viewInfo.subresourceRange.layerCount = 1;
 
-            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
+            if (vkCreateImageView(device.device(), &viewInfo, device.allocationCallbacks(), &depthImageViews[i]) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create texture image view!");
             }
         }
     }
 
     void LveSwapChain::createSyncObjects() {
+        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+        if (oldSwapChain != nullptr) {
+            // The frames in flight signal the previous swap chain's fences, keeping them (and the
+            // frame slot) lets acquireNextImage wait for those frames instead of the device idling.
+            imageAvailableSemaphores = std::move(oldSwapChain->imageAvailableSemaphores);
+            renderFinishedSemaphores = std::move(oldSwapChain->renderFinishedSemaphores);
+            inFlightFences = std::move(oldSwapChain->inFlightFences);
+            currentFrame = oldSwapChain->currentFrame;
+            return;
+        }
+
         imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
         inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-        imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -359,11 +369,11 @@ namespace lve {
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
         for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
+            if (vkCreateSemaphore(device.device(), &semaphoreInfo, device.allocationCallbacks(), &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
-                vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
+                vkCreateSemaphore(device.device(), &semaphoreInfo, device.allocationCallbacks(), &renderFinishedSemaphores[i]) !=
                 VK_SUCCESS ||
-                vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+                vkCreateFence(device.device(), &fenceInfo, device.allocationCallbacks(), &inFlightFences[i]) != VK_SUCCESS) {
                 throw std::runtime_error("failed to create synchronization objects for a frame!");
             }
         }
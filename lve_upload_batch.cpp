@@ -0,0 +1,370 @@
+#include "lve_upload_batch.hpp"
+#include "lve_staging_ring.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lve {
+
+    namespace {
+
+        // Everything a freshly uploaded buffer range is used for afterwards.
+        constexpr VkPipelineStageFlags BUFFER_READ_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                VK_PIPELINE_STAGE_TRANSFER_BIT;
+        constexpr VkAccessFlags BUFFER_READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+    }  // namespace
+
+    LveUploadBatch::Token::~Token() {
+        // The command buffers and the staging memory may still be in use until the fence signals.
+        if (fence != VK_NULL_HANDLE) {
+            wait();
+            vkDestroyFence(lveDevice.device(), fence, lveDevice.allocationCallbacks());
+        }
+        if (transferDone != VK_NULL_HANDLE) vkDestroySemaphore(lveDevice.device(), transferDone, lveDevice.allocationCallbacks());
+        if (transferCommands != VK_NULL_HANDLE) {
+            vkFreeCommandBuffers(lveDevice.device(), lveDevice.getTransferCommandPool(), 1, &transferCommands);
+        }
+        if (graphicsCommands != VK_NULL_HANDLE) {
+            vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), 1, &graphicsCommands);
+        }
+    }
+
+    bool LveUploadBatch::Token::isComplete() const {
+        for (const auto &token : previous) {
+            if (!token->isComplete()) return false;
+        }
+        return vkGetFenceStatus(lveDevice.device(), fence) == VK_SUCCESS;
+    }
+
+    void LveUploadBatch::Token::wait() const {
+        for (const auto &token : previous) token->wait();
+        vkWaitForFences(lveDevice.device(), 1, &fence, VK_TRUE, UINT64_MAX);
+    }
+
+    LveUploadBatch::~LveUploadBatch() {
+        flush();
+    }
+
+    VkCommandBuffer LveUploadBatch::beginCommandBuffer(VkCommandPool pool) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = pool;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+    }
+
+    VkCommandBuffer LveUploadBatch::getCommandBuffer() {
+        if (graphicsCommands == VK_NULL_HANDLE) graphicsCommands = beginCommandBuffer(lveDevice.getCommandPool());
+        return graphicsCommands;
+    }
+
+    VkCommandBuffer LveUploadBatch::getTransferCommandBuffer() {
+        if (!lveDevice.hasDedicatedTransferQueue()) return getCommandBuffer();
+        if (transferCommands == VK_NULL_HANDLE) transferCommands = beginCommandBuffer(lveDevice.getTransferCommandPool());
+        return transferCommands;
+    }
+
+    void LveUploadBatch::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset,
+                                    VkDeviceSize srcOffset) {
+        VkCommandBuffer commandBuffer = getTransferCommandBuffer();
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+        stats.copies++;
+
+        if (!lveDevice.hasDedicatedTransferQueue()) {
+            sharedQueueCopies = true;
+            return;
+        }
+        // Release on the transfer queue, acquire on the graphics queue; the two barriers must match.
+        const auto &families = lveDevice.queueFamilyIndices();
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = families.transferFamily;
+        barrier.dstQueueFamilyIndex = families.graphicsFamily;
+        barrier.buffer = dstBuffer;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = BUFFER_READ_ACCESS;
+        vkCmdPipelineBarrier(getCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, BUFFER_READ_STAGES,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+        stats.ownershipTransfers++;
+    }
+
+    void LveUploadBatch::copyBufferToImage(
+            VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount, uint32_t mipLevels) {
+        beginImageCopy(image, layerCount, mipLevels);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+
+        vkCmdCopyBufferToImage(getTransferCommandBuffer(), buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        stats.copies++;
+
+        endImageCopy(image, layerCount, mipLevels);
+    }
+
+    void LveUploadBatch::uploadBuffer(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset) {
+        const auto *bytes = static_cast<const char *>(data);
+        VkDeviceSize chunkBytes = lveDevice.stagingRing().getMaxRegion();
+        while (size > 0) {
+            VkDeviceSize chunk = std::min(size, chunkBytes);
+            Staged staged = stage(bytes, chunk, 16);
+            copyBuffer(staged.buffer, dstBuffer, chunk, dstOffset, staged.offset);
+            bytes += chunk;
+            dstOffset += chunk;
+            size -= chunk;
+        }
+    }
+
+    void LveUploadBatch::uploadBuffer(LveBuffer &dstBuffer, const void *data, VkDeviceSize size,
+                                      VkDeviceSize dstOffset) {
+        if (!dstBuffer.isHostWritable()) {
+            uploadBuffer(dstBuffer.getBuffer(), data, size, dstOffset);
+            return;
+        }
+        // Only freshly allocated ranges are uploaded to, so no frame in flight reads what we overwrite.
+        dstBuffer.map();
+        dstBuffer.writeToBuffer(const_cast<void *>(data), size, dstOffset);
+        stats.directWrites++;
+        stats.directBytes += size;
+    }
+
+    void LveUploadBatch::uploadImage(VkImage image, const void *pixels, uint32_t width, uint32_t height,
+                                     uint32_t pixelSize, uint32_t layerCount, uint32_t mipLevels) {
+        beginImageCopy(image, layerCount, mipLevels);
+
+        // Whole rows per region, as many as fit, in multiples of the copy queue's granularity. A
+        // queue that only copies whole mips gets a single region, staged on its own if need be.
+        const auto *bytes = static_cast<const char *>(pixels);
+        VkDeviceSize rowBytes = static_cast<VkDeviceSize>(width) * pixelSize;
+        uint32_t rowsPerChunk = static_cast<uint32_t>(
+                std::max<VkDeviceSize>(1, lveDevice.stagingRing().getMaxRegion() / rowBytes));
+        if (lveDevice.hasDedicatedTransferQueue()) {
+            const VkExtent3D &granularity = lveDevice.queueFamilyIndices().transferGranularity;
+            if (granularity.height == 0) {
+                rowsPerChunk = height;
+            } else {
+                rowsPerChunk = std::max(granularity.height, rowsPerChunk / granularity.height * granularity.height);
+            }
+        }
+        for (uint32_t layer = 0; layer < layerCount; layer++) {
+            for (uint32_t row = 0; row < height; row += rowsPerChunk) {
+                uint32_t rows = std::min(rowsPerChunk, height - row);
+                Staged staged = stage(bytes + (static_cast<VkDeviceSize>(layer) * height + row) * rowBytes,
+                                      rows * rowBytes, 16);
+
+                VkBufferImageCopy region{};
+                region.bufferOffset = staged.offset;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel = 0;
+                region.imageSubresource.baseArrayLayer = layer;
+                region.imageSubresource.layerCount = 1;
+                region.imageOffset = {0, static_cast<int32_t>(row), 0};
+                region.imageExtent = {width, rows, 1};
+                vkCmdCopyBufferToImage(getTransferCommandBuffer(), staged.buffer, image,
+                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+                stats.copies++;
+            }
+        }
+
+        endImageCopy(image, layerCount, mipLevels);
+    }
+
+    LveUploadBatch::Staged LveUploadBatch::stage(const void *data, VkDeviceSize size, VkDeviceSize alignment) {
+        auto &ring = lveDevice.stagingRing();
+        for (;;) {
+            auto region = size <= ring.getMaxRegion() ? ring.allocate(size, alignment) : LveStagingRing::Region{};
+            if (region.size > 0) {
+                std::memcpy(region.mapped, data, size);
+                stagingRegions.push_back(region.id);
+                return {region.buffer, region.offset};
+            }
+            if (stagingRegions.empty()) {
+                // Other batches' unsubmitted uploads fill the ring (or a single row is larger than
+                // a region): stage through a buffer of its own.
+                auto stagingBuffer = std::make_unique<LveBuffer>(
+                        lveDevice,
+                        size,
+                        1,
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                stagingBuffer->map();
+                stagingBuffer->writeToBuffer(const_cast<void *>(data));
+                VkBuffer buffer = stagingBuffer->getBuffer();
+                keepAlive(std::move(stagingBuffer));
+                stats.stagingBuffers++;
+                return {buffer, 0};
+            }
+            // Our own regions fill the ring: send them off, the ring then waits for the oldest.
+            partialSubmits.push_back(submitRecorded({}));
+        }
+    }
+
+    void LveUploadBatch::beginImageCopy(VkImage image, uint32_t layerCount, uint32_t mipLevels) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        vkCmdPipelineBarrier(getTransferCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    void LveUploadBatch::endImageCopy(VkImage image, uint32_t layerCount, uint32_t mipLevels) {
+        if (!lveDevice.hasDedicatedTransferQueue()) return;
+        // Copies split over several submissions leave the image with the transfer family until here.
+        const auto &families = lveDevice.queueFamilyIndices();
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.srcQueueFamilyIndex = families.transferFamily;
+        barrier.dstQueueFamilyIndex = families.graphicsFamily;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        vkCmdPipelineBarrier(getTransferCommandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(getCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+        stats.ownershipTransfers++;
+    }
+
+    void LveUploadBatch::keepAlive(std::unique_ptr<LveBuffer> stagingBuffer) {
+        stagingBuffers.push_back(std::move(stagingBuffer));
+    }
+
+    std::shared_ptr<LveUploadBatch::Token> LveUploadBatch::submit() {
+        if (isEmpty() && partialSubmits.empty()) {
+            stagingBuffers.clear();
+            return nullptr;
+        }
+        std::vector<std::shared_ptr<Token>> previous;
+        previous.swap(partialSubmits);
+        return submitRecorded(std::move(previous));
+    }
+
+    std::shared_ptr<LveUploadBatch::Token> LveUploadBatch::submitRecorded(std::vector<std::shared_ptr<Token>> previous) {
+        auto token = std::make_shared<Token>(lveDevice);
+        token->previous = std::move(previous);
+
+        if (transferCommands != VK_NULL_HANDLE) {
+            vkEndCommandBuffer(transferCommands);
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            if (vkCreateSemaphore(lveDevice.device(), &semaphoreInfo, lveDevice.allocationCallbacks(), &token->transferDone) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload semaphore!");
+            }
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &transferCommands;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &token->transferDone;
+            if (vkQueueSubmit(lveDevice.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit upload command buffer!");
+            }
+            token->transferCommands = transferCommands;
+            transferCommands = VK_NULL_HANDLE;
+        }
+
+        VkCommandBuffer commandBuffer = getCommandBuffer();
+        if (sharedQueueCopies) {
+            // Same queue: a plain barrier makes the copies visible to whatever reads them next.
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = BUFFER_READ_ACCESS;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, BUFFER_READ_STAGES,
+                                 0, 1, &barrier, 0, nullptr, 0, nullptr);
+            sharedQueueCopies = false;
+        }
+        vkEndCommandBuffer(commandBuffer);
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(lveDevice.device(), &fenceInfo, lveDevice.allocationCallbacks(), &token->fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload fence!");
+        }
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        if (token->transferDone != VK_NULL_HANDLE) {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &token->transferDone;
+            submitInfo.pWaitDstStageMask = &waitStage;
+        }
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, token->fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+        stats.submits++;
+
+        token->graphicsCommands = commandBuffer;
+        token->stagingBuffers = std::move(stagingBuffers);
+        graphicsCommands = VK_NULL_HANDLE;
+        stagingBuffers.clear();
+        lveDevice.stagingRing().release(stagingRegions, token);
+        stagingRegions.clear();
+        return token;
+    }
+
+    void LveUploadBatch::flush() {
+        if (auto token = submit()) token->wait();
+    }
+
+}  // namespace lve
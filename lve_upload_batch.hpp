@@ -0,0 +1,134 @@
+#ifndef VULKANTEST_LVE_UPLOAD_BATCH_HPP
+#define VULKANTEST_LVE_UPLOAD_BATCH_HPP
+
+#include "lve_buffer.hpp"
+#include "lve_device.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Records many transfer commands (buffer copies, image copies, layout transitions, mip blits)
+     * and submits them together with a fence.
+     *
+     * This replaces LveDevice::beginSingleTimeCommands / endSingleTimeCommands, which submit every
+     * copy separately and wait for the queue to go idle after each one. uploadBuffer() and
+     * uploadImage() stage the data in the device's LveStagingRing; staging buffers handed to
+     * keepAlive() are released once the submission's fence signals. A batch can be reused after
+     * submit(); a batch destroyed with recorded but unsubmitted commands submits them and waits.
+     *
+     * When the batch's own uploads fill the staging ring, it submits what it has recorded so far
+     * and carries on; the token submit() returns then covers those earlier submissions as well.
+     *
+     * uploadBuffer() with an LveBuffer that is host writable (device local memory on integrated and
+     * software GPUs, see LveDevice::hasUnifiedMemory) skips all of that: the data is copied straight
+     * into the buffer and nothing is recorded. Queue submission makes host writes visible to the
+     * device, so the data is ready for any frame submitted after the call.
+     *
+     * With a dedicated transfer queue (LveDevice::hasDedicatedTransferQueue) the copies run there,
+     * followed by a release of the written ranges to the graphics family. A second, small command
+     * buffer on the graphics queue waits on a semaphore, acquires them and runs the commands
+     * recorded through getCommandBuffer() (mip blits need a graphics queue). Without one, the
+     * whole batch is a single graphics command buffer.
+     */
+    class LveUploadBatch {
+    public:
+        // One submission: wait on it, or poll it from the render loop.
+        class Token {
+        public:
+            explicit Token(LveDevice &device) : lveDevice{device} {}
+            ~Token();
+
+            Token(const Token&) = delete;
+            Token &operator=(const Token&) = delete;
+
+            bool isComplete() const;
+            void wait() const;
+
+        private:
+            friend class LveUploadBatch;
+            LveDevice &lveDevice;
+            VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+            VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+            VkSemaphore transferDone = VK_NULL_HANDLE;
+            VkFence fence = VK_NULL_HANDLE;  // signals after the graphics part, so after everything
+            std::vector<std::unique_ptr<LveBuffer>> stagingBuffers;
+            std::vector<std::shared_ptr<Token>> previous;  // submitted early by the same batch
+        };
+
+        struct Stats {
+            uint32_t submits = 0;
+            uint32_t copies = 0;              // buffer and image copies recorded through the batch
+            uint32_t ownershipTransfers = 0;  // ranges released by the transfer queue to graphics
+            uint32_t stagingBuffers = 0;      // uploads that found no room in the staging ring
+            uint32_t directWrites = 0;        // buffer uploads written in place, no staging or copy
+            VkDeviceSize directBytes = 0;
+        };
+
+        explicit LveUploadBatch(LveDevice &device) : lveDevice{device} {}
+        ~LveUploadBatch();
+
+        LveUploadBatch(const LveUploadBatch&) = delete;
+        LveUploadBatch &operator=(const LveUploadBatch&) = delete;
+
+        // Graphics queue commands that run after the batch's copies, for barriers and blits the
+        // batch has no helper for. Begins recording on first use.
+        VkCommandBuffer getCommandBuffer();
+
+        // The destination range is readable as vertex, index, uniform or storage data (and as a
+        // transfer source) once the submission completes.
+        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0,
+                        VkDeviceSize srcOffset = 0);
+        // Copies into mip 0 of an image in UNDEFINED layout and leaves all its mips in
+        // TRANSFER_DST_OPTIMAL, owned by the graphics queue, for the commands of getCommandBuffer().
+        void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount,
+                               uint32_t mipLevels = 1);
+        // Copies data through the staging ring into dstBuffer, in several pieces if it is larger
+        // than a ring region. data can be freed as soon as this returns.
+        void uploadBuffer(VkBuffer dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // Writes data into dstBuffer directly when it is host writable, stages it like above otherwise.
+        void uploadBuffer(LveBuffer &dstBuffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+        // Tightly packed pixels of every layer into mip 0, in bands of rows; leaves the image like
+        // copyBufferToImage does.
+        void uploadImage(VkImage image, const void *pixels, uint32_t width, uint32_t height, uint32_t pixelSize,
+                         uint32_t layerCount = 1, uint32_t mipLevels = 1);
+        // Staging memory the recorded commands read from, freed after the submission completes.
+        void keepAlive(std::unique_ptr<LveBuffer> stagingBuffer);
+
+        bool isEmpty() const { return graphicsCommands == VK_NULL_HANDLE && transferCommands == VK_NULL_HANDLE; }
+        // Submits everything recorded so far; nullptr if nothing was recorded.
+        std::shared_ptr<Token> submit();
+        // submit() and wait for it, for loaders that need the data on the GPU right away.
+        void flush();
+
+        const Stats &getStats() const { return stats; }
+
+    private:
+        struct Staged {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+        };
+
+        VkCommandBuffer getTransferCommandBuffer();
+        VkCommandBuffer beginCommandBuffer(VkCommandPool pool);
+        Staged stage(const void *data, VkDeviceSize size, VkDeviceSize alignment);
+        void beginImageCopy(VkImage image, uint32_t layerCount, uint32_t mipLevels);
+        void endImageCopy(VkImage image, uint32_t layerCount, uint32_t mipLevels);
+        std::shared_ptr<Token> submitRecorded(std::vector<std::shared_ptr<Token>> previous);
+
+        LveDevice &lveDevice;
+        VkCommandBuffer transferCommands = VK_NULL_HANDLE;  // only with a dedicated transfer queue
+        VkCommandBuffer graphicsCommands = VK_NULL_HANDLE;
+        bool sharedQueueCopies = false;  // buffer copies that need a barrier before they're read
+        std::vector<std::unique_ptr<LveBuffer>> stagingBuffers;
+        std::vector<uint64_t> stagingRegions;  // ring regions the recorded copies read from
+        std::vector<std::shared_ptr<Token>> partialSubmits;
+        Stats stats;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_UPLOAD_BATCH_HPP
@@ -0,0 +1,97 @@
+#ifndef VULKANTEST_LVE_VERTEX_DEDUP_HPP
+#define VULKANTEST_LVE_VERTEX_DEDUP_HPP
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Flat open-addressing table that assigns every distinct vertex an index in `vertices`.
+     *
+     * Vertices are compared and hashed as their raw bits (with -0.0 folded into 0.0 so the
+     * result matches Vertex::operator== for every finite value). The table is sized once from
+     * the number of vertices that can possibly be inserted and never rehashes; each slot keeps
+     * the hash next to the vertex index so most mismatches are rejected without touching the
+     * vertex array.
+     */
+    class LveVertexDedup {
+    public:
+        static_assert(sizeof(LveModel::Vertex) == 11 * sizeof(float), "Vertex must not contain padding");
+
+        // maxVertices is an upper bound on the inserts, normally the index count.
+        LveVertexDedup(std::vector<LveModel::Vertex> &vertices, size_t maxVertices) : vertices{vertices} {
+            size_t capacity = 16;
+            // Load factor stays <= 0.8 even if every vertex is unique; indexed meshes usually
+            // have several indices per vertex and end up far below that.
+            while (capacity < maxVertices + maxVertices / 4) capacity <<= 1;
+            slots.assign(capacity, Slot{0, EMPTY});
+            mask = capacity - 1;
+        }
+
+        LveVertexDedup(const LveVertexDedup&) = delete;
+        LveVertexDedup &operator=(const LveVertexDedup&) = delete;
+
+        // Returns the index of an equal vertex, appending the vertex first if it is new.
+        uint32_t findOrInsert(LveModel::Vertex vertex) {
+            canonicalizeZeros(vertex);
+            uint64_t hash = hashBits(vertex);
+            auto tag = static_cast<uint32_t>(hash >> 32);
+
+            for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+                Slot &entry = slots[slot];
+                if (entry.index == EMPTY) {
+                    entry = {tag, static_cast<uint32_t>(vertices.size())};
+                    vertices.push_back(vertex);
+                    return entry.index;
+                }
+                if (entry.tag == tag && std::memcmp(&vertices[entry.index], &vertex, sizeof(vertex)) == 0) {
+                    return entry.index;
+                }
+            }
+        }
+
+        static uint64_t hashBits(const LveModel::Vertex &vertex) {
+            uint64_t words[6] = {};
+            std::memcpy(words, &vertex, sizeof(vertex));
+
+            // Multiply-xorshift over the 44 bytes, finished with the murmur3 avalanche.
+            uint64_t hash = 0x9e3779b97f4a7c15ull ^ sizeof(vertex);
+            for (uint64_t word : words) {
+                hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+                hash ^= hash >> 29;
+            }
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+    private:
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        struct Slot {
+            uint32_t tag;    // upper hash bits
+            uint32_t index;  // into vertices, EMPTY if unused
+        };
+
+        static void canonicalizeZeros(LveModel::Vertex &vertex) {
+            uint32_t bits[11];
+            std::memcpy(bits, &vertex, sizeof(bits));
+            for (auto &b : bits) {
+                if (b == 0x80000000u) b = 0;
+            }
+            std::memcpy(&vertex, bits, sizeof(bits));
+        }
+
+        std::vector<LveModel::Vertex> &vertices;
+        std::vector<Slot> slots;
+        size_t mask = 0;
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_VERTEX_DEDUP_HPP
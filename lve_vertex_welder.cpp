@@ -0,0 +1,167 @@
+#include "lve_vertex_welder.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace lve {
+
+    namespace {
+
+        struct Cell {
+            uint64_t key;
+            uint32_t begin;  // into the vertex order sorted by cell
+            uint32_t end;
+        };
+
+        // 21 bits per axis; far apart cells that share a key only cost extra comparisons.
+        uint64_t cellKey(int64_t x, int64_t y, int64_t z) {
+            constexpr uint64_t MASK = (1u << 21) - 1;
+            return (static_cast<uint64_t>(x) & MASK) << 42 | (static_cast<uint64_t>(y) & MASK) << 21 |
+                   (static_cast<uint64_t>(z) & MASK);
+        }
+
+        float squaredDistance(const glm::vec3 &a, const glm::vec3 &b) {
+            glm::vec3 d = a - b;
+            return glm::dot(d, d);
+        }
+
+        float squaredDistance(const glm::vec2 &a, const glm::vec2 &b) {
+            glm::vec2 d = a - b;
+            return glm::dot(d, d);
+        }
+
+    }  // namespace
+
+    LveVertexWelder::Stats LveVertexWelder::weld(std::vector<LveModel::Vertex> &vertices,
+                                                 std::vector<uint32_t> &indices, const Settings &settings) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        Stats stats{};
+        stats.verticesBefore = stats.verticesAfter = static_cast<uint32_t>(vertices.size());
+        if (vertices.empty() || !(settings.positionEpsilon > 0.0f)) return stats;
+
+        float positionLimit = settings.positionEpsilon * settings.positionEpsilon;
+        float normalLimit = settings.normalEpsilon * settings.normalEpsilon;
+        float uvLimit = settings.uvEpsilon * settings.uvEpsilon;
+        auto isClose = [&](const LveModel::Vertex &a, const LveModel::Vertex &b) {
+            return squaredDistance(a.position, b.position) <= positionLimit &&
+                   squaredDistance(a.normal, b.normal) <= normalLimit &&
+                   squaredDistance(a.uv, b.uv) <= uvLimit;
+        };
+
+        // Bucket the vertices by cell; within a cell they stay in index order.
+        auto vertexCount = static_cast<uint32_t>(vertices.size());
+        float invCellSize = 1.0f / settings.positionEpsilon;
+        std::vector<int64_t> coordinates(3 * size_t{vertexCount});
+        std::vector<std::pair<uint64_t, uint32_t>> sorted(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            int64_t *cell = &coordinates[3 * size_t{v}];
+            for (int axis = 0; axis < 3; axis++) {
+                cell[axis] = static_cast<int64_t>(std::floor(vertices[v].position[axis] * invCellSize));
+            }
+            sorted[v] = {cellKey(cell[0], cell[1], cell[2]), v};
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<Cell> cells;
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            if (cells.empty() || cells.back().key != sorted[i].first) cells.push_back({sorted[i].first, i, i});
+            cells.back().end = i + 1;
+        }
+        stats.cells = static_cast<uint32_t>(cells.size());
+
+        // Each vertex links to the lowest numbered earlier vertex within tolerance. A vertex is
+        // only written by the thread that owns its cell.
+        std::vector<uint32_t> links(vertexCount);
+        auto linkCells = [&](size_t firstCell, size_t lastCell) {
+            std::vector<const Cell *> neighbours;
+            for (size_t c = firstCell; c < lastCell; c++) {
+                const Cell &cell = cells[c];
+                const int64_t *center = &coordinates[3 * size_t{sorted[cell.begin].second}];
+                neighbours.clear();
+                for (int64_t dx = -1; dx <= 1; dx++) {
+                    for (int64_t dy = -1; dy <= 1; dy++) {
+                        for (int64_t dz = -1; dz <= 1; dz++) {
+                            uint64_t key = cellKey(center[0] + dx, center[1] + dy, center[2] + dz);
+                            auto it = std::lower_bound(cells.begin(), cells.end(), key,
+                                                       [](const Cell &cell, uint64_t key) { return cell.key < key; });
+                            if (it != cells.end() && it->key == key &&
+                                std::find(neighbours.begin(), neighbours.end(), &*it) == neighbours.end()) {
+                                neighbours.push_back(&*it);
+                            }
+                        }
+                    }
+                }
+                for (uint32_t i = cell.begin; i < cell.end; i++) {
+                    uint32_t v = sorted[i].second;
+                    uint32_t link = v;
+                    for (const Cell *neighbour : neighbours) {
+                        for (uint32_t j = neighbour->begin; j < neighbour->end; j++) {
+                            uint32_t u = sorted[j].second;
+                            if (u >= link) break;  // sorted by index within a cell
+                            if (isClose(vertices[u], vertices[v])) {
+                                link = u;
+                                break;
+                            }
+                        }
+                    }
+                    links[v] = link;
+                }
+            }
+        };
+
+        unsigned int threadCount = settings.threadCount ? settings.threadCount
+                                                        : std::max(1u, std::thread::hardware_concurrency());
+        threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, cells.size()));
+        stats.threads = threadCount;
+        {
+            // Split the cells into runs of about the same number of vertices.
+            std::vector<size_t> splits{0};
+            for (unsigned int t = 1; t < threadCount; t++) {
+                uint64_t target = uint64_t{vertexCount} * t / threadCount;
+                auto it = std::lower_bound(cells.begin() + splits.back(), cells.end(), target,
+                                           [](const Cell &cell, uint64_t target) { return cell.begin < target; });
+                splits.push_back(static_cast<size_t>(it - cells.begin()));
+            }
+            splits.push_back(cells.size());
+
+            std::vector<std::thread> workers;
+            for (unsigned int t = 1; t < threadCount; t++) {
+                workers.emplace_back(linkCells, splits[t], splits[t + 1]);
+            }
+            linkCells(splits[0], splits[1]);
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        }
+
+        // Follow the links in index order, so every target is resolved before it is needed.
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            if (links[v] == v) continue;
+            uint32_t survivor = links[links[v]];
+            links[v] = isClose(vertices[survivor], vertices[v]) ? survivor : v;
+        }
+
+        std::vector<uint32_t> remap(vertexCount);
+        uint32_t survivors = 0;
+        for (uint32_t v = 0; v < vertexCount; v++) {
+            if (links[v] == v) {
+                remap[v] = survivors;
+                vertices[survivors++] = vertices[v];
+            } else {
+                remap[v] = remap[links[v]];
+            }
+        }
+        vertices.resize(survivors);
+        for (auto &index : indices) {
+            index = remap[index];
+        }
+
+        stats.verticesAfter = survivors;
+        stats.ms = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+        return stats;
+    }
+
+}  // namespace lve
@@ -0,0 +1,52 @@
+#ifndef VULKANTEST_LVE_VERTEX_WELDER_HPP
+#define VULKANTEST_LVE_VERTEX_WELDER_HPP
+
+#include "lve_model.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+    /**
+     * Merges vertices that differ only by float noise, which exact deduplication (LveVertexDedup)
+     * keeps apart.
+     *
+     * Vertices are bucketed into a uniform grid with cells as large as the position tolerance, so
+     * every vertex within tolerance lies in one of the 27 cells around it. Each cell is searched
+     * independently, in parallel: a vertex picks the lowest numbered earlier vertex whose
+     * position, normal and uv are all within tolerance. A sequential pass then follows these
+     * links to the surviving vertex, refusing links that would end further than the tolerance
+     * away, so merges never chain across a surface. The result does not depend on the thread
+     * count.
+     *
+     * Colors are not compared: OBJ stores them per position, so nearly coincident positions
+     * carry nearly the same color. A merged vertex keeps the attributes of the survivor.
+     */
+    class LveVertexWelder {
+    public:
+        struct Settings {
+            float positionEpsilon = 0.0f;  // model space distance, 0 disables welding
+            float normalEpsilon = 0.0f;    // distance between the normals, about the angle in radians
+            float uvEpsilon = 0.0f;
+            unsigned int threadCount = 0;  // 0 = one per hardware core
+        };
+
+        struct Stats {
+            uint32_t verticesBefore = 0;
+            uint32_t verticesAfter = 0;
+            uint32_t cells = 0;
+            unsigned int threads = 0;
+            double ms = 0.0;
+        };
+
+        // Rewrites indices to the surviving vertices and drops the merged ones from vertices,
+        // keeping the order of the rest. Triangles may become degenerate; removing them is up
+        // to the caller.
+        static Stats weld(std::vector<LveModel::Vertex> &vertices, std::vector<uint32_t> &indices,
+                          const Settings &settings);
+    };
+
+}  // namespace lve
+
+#endif //VULKANTEST_LVE_VERTEX_WELDER_HPP
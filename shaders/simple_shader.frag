@@ -21,15 +21,11 @@ layout (set = 0, binding = 0) uniform GlobalUbo {
     int numLights;
 } ubo;
 
-layout (set = 0, binding = 1) uniform sampler2D textSampler;
-layout (set = 0, binding = 2) uniform sampler2D textSampler2; //Add more for extra textures
-layout (set = 0, binding = 3) uniform sampler2D textSampler3;
-layout (set = 0, binding = 4) uniform sampler2D textSampler4;
-layout (set = 0, binding = 5) uniform sampler2D textSampler5;
+layout (set = 1, binding = 0) uniform sampler2D textSampler; // the draw's texture, bound per material
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix;
-    mat4 normalMatrix; //[3][3] is the Texture Binding
+    mat4 normalMatrix; //[3][3] is 1 when textSampler is used
 } push;
 
 void main()
@@ -60,18 +56,9 @@ void main()
         specularLight += blinnTerm * intensity;
     }
 
-    int fragTextureId = int(round(push.normalMatrix[3][3]));
     vec4 tFragColor = vec4(fragColor,1.0);
-    if (fragTextureId == 1)
+    if (push.normalMatrix[3][3] > 0.5)
         tFragColor = texture(textSampler,fragTexCoord);  //fragTexCoord is 2D
-    if (fragTextureId == 2)
-        tFragColor = texture(textSampler2, fragTexCoord); // Add more for extra textures
-    if (fragTextureId == 3)
-        tFragColor = texture(textSampler3, fragTexCoord);
-    if (fragTextureId == 4)
-        tFragColor = texture(textSampler4, fragTexCoord);
-    if (fragTextureId == 5)
-        tFragColor = texture(textSampler5, fragTexCoord);
 
     outColor = vec4(diffuseLight * tFragColor.xyz + specularLight * tFragColor.xyz,1.0);
 }
\ No newline at end of file
@@ -26,7 +26,7 @@ layout (set = 0, binding = 0) uniform GlobalUbo {
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix;
-    mat4 normalMatrix;  //[3][3] is the Texture Binding
+    mat4 normalMatrix;  //[3][3] is 1 for textured draws
 } push;
 
 void main() {
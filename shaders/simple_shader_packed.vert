@@ -0,0 +1,50 @@
+#version 450
+
+// Same as simple_shader.vert, for LveModel::PackedVertex input.
+layout (location = 0) in vec4 position;  // R16G16B16A16_UNORM, dequantized by the model matrix
+layout (location = 1) in vec4 color;     // R8G8B8A8_UNORM
+layout (location = 2) in vec2 normal;    // R16G16_SNORM, octahedral encoded
+layout (location = 3) in vec2 uv;        // R16G16_SFLOAT
+
+layout (location = 0) out vec3 fragColor;
+layout (location = 1) out vec3 fragPosWorld;
+layout (location = 2) out vec3 fragNormalWorld;
+layout (location = 3) out vec2 fragTexCoord;
+
+struct PointLight {
+    vec4 position; // ignore w
+    vec4 color; // w is intensity
+};
+
+layout (set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor;
+    PointLight pointLights[10];
+    int numLights;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix;   // includes the mesh bounds the positions are quantized to
+    mat4 normalMatrix;  //[3][3] is 1 for textured draws
+} push;
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    vec4 positionWorld = push.modelMatrix * vec4(position.xyz, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+
+    fragNormalWorld = normalize(mat3(push.normalMatrix) * octahedralDecode(normal));
+    fragPosWorld = positionWorld.xyz;
+    fragColor = color.rgb;
+    fragTexCoord = uv;
+
+}
@@ -26,7 +26,7 @@ namespace lve {
     }
 
     PointLightSystem::~PointLightSystem() {
-        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, lveDevice.allocationCallbacks());
     }
 
     void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
@@ -44,7 +44,7 @@ namespace lve {
         pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
         pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
-        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) !=
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutCreateInfo, lveDevice.allocationCallbacks(), &pipelineLayout) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
@@ -110,7 +110,7 @@ namespace lve {
                 pipelineLayout,
                 0, 1,
                 &frameInfo.globalDescriptorSet,
-                0, nullptr);
+                1, &frameInfo.globalUboOffset);
 
         // Iterated through in reverese order of distance
         for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
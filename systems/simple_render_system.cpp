@@ -8,6 +8,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <array>
@@ -17,29 +18,31 @@ namespace lve {
     struct SimplePushConstantData {
         glm::mat4 modelMatrix{1.f};
         glm::mat4 normalMatrix{1.f}; // Is really just a 3x3 matrix, so we will use the extra values to send data.
-        // normalMatrix[3][3] will be the textureBinding;
+        // normalMatrix[3][3] is 1 to sample the bound texture set, 0 for vertex colors.
     };
 
     // 16 bytes for offset, 12 bytes for color - aligns to 16 bytes.
     // Each new value must end or begin on a 4 byte boundary.
     uint32_t pushConstantDataSize = sizeof(SimplePushConstantData); //16 + 12;
 
-    SimpleRenderSystem::SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : lveDevice{device} {
-        createPipelineLayout(globalSetLayout);
+    SimpleRenderSystem::SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                                           VkDescriptorSetLayout textureSetLayout) : lveDevice{device} {
+        createPipelineLayout(globalSetLayout, textureSetLayout);
         createPipeline(renderPass);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem() {
-        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+        vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, lveDevice.allocationCallbacks());
     }
 
-    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
+    void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout,
+                                                  VkDescriptorSetLayout textureSetLayout) {
         VkPushConstantRange pushConstantRange{};
         pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
         pushConstantRange.offset = 0;
         pushConstantRange.size = pushConstantDataSize;
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, textureSetLayout};
 
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -48,7 +51,7 @@ namespace lve {
         pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
         pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
 
-        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) !=
+        if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutCreateInfo, lveDevice.allocationCallbacks(), &pipelineLayout) !=
             VK_SUCCESS) {
             throw std::runtime_error("failed to create pipeline layout!");
         }
@@ -68,10 +71,98 @@ namespace lve {
                 "../shaders/simple_shader.frag.spv",
                 pipelineConfig
         );
+
+        pipelineConfig.bindingDescriptions = LveModel::PackedVertex::getBindingDescriptions();
+        pipelineConfig.attributeDescriptions = LveModel::PackedVertex::getAttributeDescriptions();
+        packedPipeline = std::make_unique<LvePipeline>(
+                lveDevice,
+                "../shaders/simple_shader_packed.vert.spv",
+                "../shaders/simple_shader.frag.spv",
+                pipelineConfig
+        );
+    }
+
+    uint32_t SimpleRenderSystem::selectLod(const LveGameObject &gameObject, const glm::mat4 &modelMatrix,
+                                           const LveCamera &camera) const {
+        const auto &model = *gameObject.model;
+        uint32_t lodCount = model.getLodCount();
+        if (lodCount <= 1) return 0;
+
+        // World space errors shrink with distance by the projection's vertical focal length.
+        float worldScale = std::max(glm::length(glm::vec3(modelMatrix[0])),
+                                    std::max(glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2]))));
+        glm::vec3 center{modelMatrix * glm::vec4(model.getBoundsCenter(), 1.f)};
+        float distance = glm::length(center - camera.getCameraPos()) - model.getBoundsRadius() * worldScale;
+        float projection = std::abs(camera.getProjection()[1][1]) * worldScale / std::max(distance, 1e-3f);
+        auto screenError = [&](uint32_t lod) { return model.getLod(lod).error * projection; };
+
+        uint32_t lod = std::min(gameObject.lodLevel, lodCount - 1);
+        while (lod > 0 && screenError(lod) > lodSettings.maxScreenError * (1.f + lodSettings.hysteresis)) {
+            lod--;
+        }
+        while (lod + 1 < lodCount && screenError(lod + 1) < lodSettings.maxScreenError * (1.f - lodSettings.hysteresis)) {
+            lod++;
+        }
+        return lod;
     }
 
     void SimpleRenderSystem::render(FrameInfo &frameInfo) {
+        stats = {};
+        glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getView();
+
+        // Collect one item per submesh, then sort so that pipeline, texture and buffer binds are
+        // only issued when they actually change.
+        objectDraws.clear();
+        drawItems.clear();
+        for (auto &kv : frameInfo.gameObjects) {
+            auto &gameObject = kv.second;
+            if (gameObject.model == nullptr) continue;
+            auto object = static_cast<uint32_t>(objectDraws.size());
+            objectDraws.push_back({&gameObject, gameObject.transform.mat4()});
+
+            const auto &model = *gameObject.model;
+            gameObject.lodLevel = selectLod(gameObject, objectDraws.back().modelMatrix, frameInfo.camera);
+            if (stats.objectsPerLod.size() <= gameObject.lodLevel) {
+                stats.objectsPerLod.resize(gameObject.lodLevel + 1, 0);
+                stats.trianglesPerLod.resize(gameObject.lodLevel + 1, 0);
+            }
+            stats.objectsPerLod[gameObject.lodLevel]++;
+            stats.trianglesPerLod[gameObject.lodLevel] += model.getLod(gameObject.lodLevel).indexCount / 3;
+
+            if (model.getSubmeshes().empty()) {
+                drawItems.push_back({object, nullptr, gameObject.textureBinding});
+            }
+            for (const auto &submesh : model.getSubmeshes()) {
+                int32_t textureBinding = gameObject.textureBinding;
+                if (submesh.material >= 0 && model.getMaterials()[submesh.material].textureBinding >= 0) {
+                    textureBinding = model.getMaterials()[submesh.material].textureBinding;
+                }
+                drawItems.push_back({object, &submesh, textureBinding});
+            }
+        }
+        auto bufferKey = [this](const DrawItem &item) -> const void * {
+            const auto &model = objectDraws[item.object].gameObject->model;
+            if (model->getGeometryPool() != nullptr) return model->getGeometryPool();
+            return model.get();
+        };
+        std::stable_sort(drawItems.begin(), drawItems.end(), [&](const DrawItem &a, const DrawItem &b) {
+            auto formatA = objectDraws[a.object].gameObject->model->getVertexFormat();
+            auto formatB = objectDraws[b.object].gameObject->model->getVertexFormat();
+            if (formatA != formatB) return formatA < formatB;
+            if (a.textureBinding != b.textureBinding) return a.textureBinding < b.textureBinding;
+            return std::less<const void *>{}(bufferKey(a), bufferKey(b));
+        });
+
         lvePipeline->bind(frameInfo.commandBuffer);
+        auto boundFormat = LveModel::VertexFormat::Full;
+        // Vertex input bindings survive pipeline switches, so pooled models only rebind when
+        // the pool or the index type changes.
+        LveModel *boundModel = nullptr;
+        LveGeometryPool *boundPool = nullptr;
+        VkIndexType boundIndexType = VK_INDEX_TYPE_UINT32;
+        VkDescriptorSet boundTextureSet = VK_NULL_HANDLE;
+        uint32_t pushedObject = UINT32_MAX;
+        bool pushedTextured = false;
 
         vkCmdBindDescriptorSets(
                 frameInfo.commandBuffer,
@@ -79,25 +170,95 @@ namespace lve {
                 pipelineLayout,
                 0, 1,
                 &frameInfo.globalDescriptorSet,
-                0, nullptr);
+                1, &frameInfo.globalUboOffset);
 
-        for (auto &kv : frameInfo.gameObjects) {
-            auto &gameObject = kv.second;
-            if (gameObject.model == nullptr) continue;
-            SimplePushConstantData push{};
-            push.modelMatrix = gameObject.transform.mat4();
-            push.normalMatrix = gameObject.transform.normalMatrix();
-            push.normalMatrix[3][3] = static_cast<float>(gameObject.textureBinding); // Not ideal, but limited with 128 bytes.
-            vkCmdPushConstants(
-                    frameInfo.commandBuffer,
-                    pipelineLayout,
-                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                    0,
-                    pushConstantDataSize,
-                    &push);
-            gameObject.model->bind(frameInfo.commandBuffer);
-            gameObject.model->draw(frameInfo.commandBuffer);
+        for (const auto &item : drawItems) {
+            auto &objectDraw = objectDraws[item.object];
+            auto &gameObject = *objectDraw.gameObject;
+            auto &model = *gameObject.model;
+            auto format = model.getVertexFormat();
+            if (format != boundFormat) {
+                auto &pipeline = format == LveModel::VertexFormat::Packed ? packedPipeline : lvePipeline;
+                pipeline->bind(frameInfo.commandBuffer);
+                boundFormat = format;
+            }
+
+            // Untextured draws keep whatever texture set is bound, the shader ignores it.
+            VkDescriptorSet textureSet = VK_NULL_HANDLE;
+            if (item.textureBinding >= 0 && item.textureBinding < static_cast<int32_t>(textureSets.size())) {
+                textureSet = textureSets[item.textureBinding];
+            }
+            bool textured = textureSet != VK_NULL_HANDLE;
+            if (!textured && boundTextureSet == VK_NULL_HANDLE) {
+                auto first = std::find_if(textureSets.begin(), textureSets.end(),
+                                          [](VkDescriptorSet set) { return set != VK_NULL_HANDLE; });
+                if (first != textureSets.end()) textureSet = *first;
+            }
+            if (textureSet != VK_NULL_HANDLE && textureSet != boundTextureSet) {
+                vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+                                        1, 1, &textureSet, 0, nullptr);
+                boundTextureSet = textureSet;
+                stats.textureBinds++;
+            }
+
+            if (item.object != pushedObject || textured != pushedTextured) {
+                SimplePushConstantData push{};
+                push.modelMatrix = objectDraw.modelMatrix * model.getPositionDequantization();
+                push.normalMatrix = gameObject.transform.normalMatrix();
+                push.normalMatrix[3][3] = textured ? 1.f : 0.f; // Not ideal, but limited with 128 bytes.
+                vkCmdPushConstants(
+                        frameInfo.commandBuffer,
+                        pipelineLayout,
+                        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                        0,
+                        pushConstantDataSize,
+                        &push);
+                pushedObject = item.object;
+                pushedTextured = textured;
+            }
+
+            LveGeometryPool *pool = model.getGeometryPool();
+            if (pool != nullptr) {
+                if (pool != boundPool || model.getIndexType() != boundIndexType) {
+                    pool->bind(frameInfo.commandBuffer, model.getIndexType());
+                    boundPool = pool;
+                    boundIndexType = model.getIndexType();
+                    boundModel = nullptr;
+                    stats.bufferBinds++;
+                }
+            } else if (&model != boundModel) {
+                model.bind(frameInfo.commandBuffer);
+                boundModel = &model;
+                boundPool = nullptr;
+                stats.bufferBinds++;
+            }
+
+            if (item.submesh == nullptr) {
+                model.draw(frameInfo.commandBuffer, gameObject.lodLevel);
+                stats.drawCalls++;
+                continue;
+            }
+            const auto &submesh = *item.submesh;
+            if (meshletCulling && gameObject.lodLevel == 0 && submesh.meshletCount > 0) {
+                // Cull in model space, the bounds are in the model's own coordinates.
+                glm::vec3 cameraPosition{glm::inverse(objectDraw.modelMatrix) * glm::vec4(frameInfo.camera.getCameraPos(), 1.f)};
+                drawRanges.clear();
+                auto cullStats = LveMeshlets::cull(model.getMeshlets().data() + submesh.firstMeshlet, submesh.meshletCount,
+                                                   viewProjection * objectDraw.modelMatrix, cameraPosition, drawRanges);
+                stats.meshlets.meshletsTested += cullStats.meshletsTested;
+                stats.meshlets.meshletsCulled += cullStats.meshletsCulled;
+                stats.meshlets.trianglesTested += cullStats.trianglesTested;
+                stats.meshlets.trianglesCulled += cullStats.trianglesCulled;
+                for (const auto &range : drawRanges) {
+                    model.drawRange(frameInfo.commandBuffer, range.firstIndex, range.indexCount);
+                    stats.drawCalls++;
+                }
+            } else {
+                auto range = model.getSubmeshRange(submesh, gameObject.lodLevel);
+                model.drawRange(frameInfo.commandBuffer, range.firstIndex, range.indexCount);
+                stats.drawCalls++;
+            }
         }
     }
 
-}
\ No newline at end of file
+}
@@ -10,6 +10,7 @@
 #include "lve_pipeline.hpp"
 #include "lve_device.hpp"
 #include "lve_frame_info.hpp"
+#include "lve_meshlets.hpp"
 
 #include <memory>
 #include <vector>
@@ -18,20 +19,65 @@ namespace lve {
     class SimpleRenderSystem {
 
     public:
-        SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        // Screen space errors are fractions of half the viewport height, 0.003 is about a pixel at 600p.
+        struct LodSettings {
+            float maxScreenError = 0.003f;
+            float hysteresis = 0.25f;  // a level must be this much better than the limit to switch
+        };
+
+        // Counts of the last render() call, indexed by LOD level. trianglesPerLod is before culling.
+        struct RenderStats {
+            std::vector<uint32_t> objectsPerLod;
+            std::vector<uint64_t> trianglesPerLod;
+            LveMeshlets::CullStats meshlets;
+            uint32_t bufferBinds = 0;  // vertex / index buffer binds, pooled models share them
+            uint32_t textureBinds = 0;  // texture descriptor set binds, draws are sorted to share them
+            uint32_t drawCalls = 0;
+        };
+
+        // textureSetLayout is set 1: one combined image sampler at binding 0.
+        SimpleRenderSystem(LveDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout,
+                           VkDescriptorSetLayout textureSetLayout);
         ~SimpleRenderSystem();
 
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
         SimpleRenderSystem &operator=(const SimpleRenderSystem&) = delete;
 
+        // Texture sets indexed by LveGameObject::textureBinding / LveModel::Material::textureBinding;
+        // VK_NULL_HANDLE entries (and bindings outside the list) draw vertex colors.
+        void setTextureSets(std::vector<VkDescriptorSet> sets) { textureSets = std::move(sets); }
+
+        // Draws every submesh of every object, sorted by pipeline, texture and vertex buffers.
         void render(FrameInfo &frameInfo);
+
+        LodSettings lodSettings{};
+        bool meshletCulling = true;  // for models built with meshlets, drawn at level 0
+        const RenderStats &getStats() const { return stats; }
     private:
-        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
+        // One submesh of one object, in the order it gets drawn.
+        struct DrawItem {
+            uint32_t object;  // into objectDraws
+            const LveModel::Submesh *submesh;  // nullptr for models without an index buffer
+            int32_t textureBinding;
+        };
+        struct ObjectDraw {
+            LveGameObject *gameObject;
+            glm::mat4 modelMatrix;
+        };
+
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout textureSetLayout);
         void createPipeline(VkRenderPass renderPass);
+        uint32_t selectLod(const LveGameObject &gameObject, const glm::mat4 &modelMatrix, const LveCamera &camera) const;
 
         LveDevice& lveDevice;
         std::unique_ptr<LvePipeline> lvePipeline;
+        std::unique_ptr<LvePipeline> packedPipeline;  // for LveModel::VertexFormat::Packed models
         VkPipelineLayout pipelineLayout;
+        RenderStats stats;
+        std::vector<VkDescriptorSet> textureSets;
+        std::vector<ObjectDraw> objectDraws;  // scratch for render()
+        std::vector<DrawItem> drawItems;
+        std::vector<LveMeshlets::DrawRange> drawRanges;  // scratch for meshlet culling
     };
 }
 